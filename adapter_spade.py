@@ -3,14 +3,566 @@
 Adapter for Spade 2D triangulator.
 """
 
+import asyncio
+import atexit
+import inspect
 import json
+import os
+import queue
+import resource
+import select
+import struct
 import subprocess
+import tempfile
+import threading
+import time
+from collections import deque
+from concurrent.futures import Future, ThreadPoolExecutor
 from pathlib import Path
-from typing import List, Tuple, Optional
+from typing import Dict, Iterator, List, Tuple, Optional
 
 # Path to the Rust CLI executable
 SPADE_CLI = Path(__file__).parent / "spade-cli" / "target" / "release" / "spade-cli"
 
+# Reuse one long-lived `spade-cli --serve` process across calls (set SPADE_SERVE=0 to disable)
+USE_SERVER = os.environ.get("SPADE_SERVE", "1") != "0"
+
+# Wire format between adapter and CLI: "json" (default, human readable) or "binary"
+WIRE_FORMAT = os.environ.get("SPADE_WIRE", "json")
+
+# "cli" talks to the spade-cli executable; "native" calls the in-process spade_py
+# extension (built from spade-py/ with maturin)
+BACKEND = os.environ.get("SPADE_BACKEND", "cli")
+
+# Per-request timeout in seconds
+TIMEOUT = 300
+
+# Content-addressed result cache: set SPADE_CACHE to a directory to enable it.
+# Entries are binary replies; the least recently used ones are evicted once the
+# directory holds more than SPADE_CACHE_MAX_BYTES (default 1 GiB)
+CACHE_DIR = os.environ.get("SPADE_CACHE") or None
+CACHE_MAX_BYTES = int(os.environ.get("SPADE_CACHE_MAX_BYTES", 1 << 30))
+_CACHE_SUFFIX = ".sprs"
+
+class SpadeError(RuntimeError):
+    """The CLI answered a request with an error (the worker itself is still usable)."""
+
+
+# Binary protocol, see spade-cli/src/binary.rs
+_REQUEST_MAGIC = b"SPRQ"
+_RESPONSE_MAGIC = b"SPRS"
+_RESPONSE_HEADER = struct.Struct("<4sHHIIII")
+_LAYOUT_F32, _LAYOUT_2D, _LAYOUT_U64 = 1, 2, 4
+
+
+def _layout_bits(coord_type: str = "f64", dims: int = 3, index_type: str = "u32") -> int:
+    return ((_LAYOUT_F32 if coord_type == "f32" else 0) | (_LAYOUT_2D if dims == 2 else 0)
+            | (_LAYOUT_U64 if index_type == "u64" else 0))
+
+
+def _layout_dtypes(layout: int):
+    """(coordinate dtype, point dimension, index dtype) of a binary reply layout."""
+    return ("<f4" if layout & _LAYOUT_F32 else "<f8", 2 if layout & _LAYOUT_2D else 3,
+            "<u8" if layout & _LAYOUT_U64 else "<u4")
+
+
+def _index_padding(layout: int, num_points: int) -> int:
+    """Zero bytes between the points and the index arrays, which start index-aligned."""
+    coord_size = 4 if layout & _LAYOUT_F32 else 8
+    dims = 2 if layout & _LAYOUT_2D else 3
+    index_size = 8 if layout & _LAYOUT_U64 else 4
+    return -(coord_size * dims * num_points) % index_size
+
+
+def _encode_json(params: dict, outer, inner_loops) -> bytes:
+    input_data = {
+        "outer": [[x, y] for x, y in outer],
+        "inner_loops": [[[x, y] for x, y in loop] for loop in inner_loops],
+        **params,
+    }
+    return json.dumps(input_data).encode()
+
+
+_MESH_KEYS = ("points", "triangles", "constraint_edges")
+
+
+def _decode_json(data: bytes):
+    """Return (mesh, info), where info holds the reply fields besides the mesh."""
+    output = json.loads(data)
+    if "error" in output:
+        raise SpadeError(f"Spade CLI failed: {output['error']}")
+    info = {key: value for key, value in output.items() if key not in _MESH_KEYS}
+    return _mesh_from_json(output), info
+
+
+def _mesh_from_json(output: dict):
+    points = [tuple(p) for p in output["points"]]
+    triangles = [tuple(t) for t in output["triangles"]]
+    lines = [tuple(e) for e in output["constraint_edges"]]
+    return points, triangles, lines
+
+
+def _encode_binary(params: dict, outer, inner_loops) -> bytes:
+    import numpy as np
+
+    loops = [np.asarray(loop, dtype="<f8").reshape(-1, 2) for loop in [outer, *inner_loops]]
+    offsets = np.zeros(len(loops) + 1, dtype="<u4")
+    np.cumsum([len(loop) for loop in loops], out=offsets[1:])
+    coords = np.concatenate(loops) if loops else np.empty((0, 2), dtype="<f8")
+
+    blob = json.dumps(params).encode()
+    header = struct.pack("<4sIII", _REQUEST_MAGIC, len(blob), len(loops), int(offsets[-1]))
+    return b"".join([header, blob, offsets.tobytes(), coords.tobytes()])
+
+
+def _decode_binary(buf):
+    """Wrap a binary reply in NumPy arrays that view `buf` directly (no copies).
+
+    Returns (mesh, info) like `_decode_json`.
+    """
+    import numpy as np
+
+    _, status, layout, num_points, num_triangles, num_edges, extra_len = _RESPONSE_HEADER.unpack_from(buf)
+    offset = _RESPONSE_HEADER.size
+    if status != 0:
+        message = bytes(buf[offset:offset + extra_len]).decode(errors="replace")
+        raise SpadeError(f"Spade CLI failed: {message}")
+
+    coord, dims, index = _layout_dtypes(layout)
+    points = np.frombuffer(buf, dtype=coord, count=dims * num_points, offset=offset).reshape(-1, dims)
+    offset += points.nbytes + _index_padding(layout, num_points)
+    triangles = np.frombuffer(buf, dtype=index, count=3 * num_triangles, offset=offset).reshape(-1, 3)
+    offset += triangles.nbytes
+    lines = np.frombuffer(buf, dtype=index, count=2 * num_edges, offset=offset).reshape(-1, 2)
+    offset += lines.nbytes
+    info = json.loads(bytes(buf[offset:offset + extra_len])) if extra_len else {}
+    return (points, triangles, lines), info
+
+
+def _readinto_exact(stream, buf):
+    """Fill `buf` (any writable buffer) from `stream`."""
+    view = memoryview(buf).cast("B")
+    pos = 0
+    while pos < len(view):
+        n = stream.readinto(view[pos:])
+        if not n:
+            raise RuntimeError("Spade CLI server exited unexpectedly")
+        pos += n
+
+
+def _read_binary(stream):
+    """Read one binary reply from `stream`, chunk by chunk, into preallocated arrays."""
+    import numpy as np
+
+    header = bytearray(_RESPONSE_HEADER.size)
+    _readinto_exact(stream, header)
+    magic, status, layout, num_points, num_triangles, num_edges, extra_len = _RESPONSE_HEADER.unpack(header)
+    if magic != _RESPONSE_MAGIC:
+        raise RuntimeError("Spade CLI sent a malformed binary reply")
+
+    coord, dims, index = _layout_dtypes(layout)
+    points = np.empty((num_points, dims), dtype=coord)
+    padding = bytearray(_index_padding(layout, num_points))
+    triangles = np.empty((num_triangles, 3), dtype=index)
+    lines = np.empty((num_edges, 2), dtype=index)
+    extra = bytearray(extra_len)
+    for buf in (points, padding, triangles, lines, extra):
+        if len(buf):
+            _readinto_exact(stream, buf)
+
+    if status != 0:
+        raise SpadeError(f"Spade CLI failed: {extra.decode(errors='replace')}")
+    info = json.loads(extra) if extra_len else {}
+    return (points, triangles, lines), info
+
+
+class _PipeReader:
+    """Buffered reads from a worker's stdout that give up at a deadline.
+
+    Every read of the pipe waits for it with select() first, so a reply that
+    stalls halfway times out like one that never starts. Large reads go straight
+    into the caller's buffer.
+    """
+
+    CHUNK = 1 << 20
+
+    def __init__(self, fd: int):
+        self.fd = fd
+        self.buffer = bytearray()
+        self.deadline: Optional[float] = None
+
+    def _wait(self):
+        remaining = self.deadline - time.monotonic()
+        if remaining <= 0 or not select.select([self.fd], [], [], remaining)[0]:
+            raise TimeoutError
+
+    def readline(self) -> bytes:
+        """One line including its newline, or what is left at end of file."""
+        start = 0
+        while True:
+            end = self.buffer.find(b"\n", start)
+            if end >= 0:
+                line = bytes(self.buffer[:end + 1])
+                del self.buffer[:end + 1]
+                return line
+            start = len(self.buffer)
+            self._wait()
+            chunk = os.read(self.fd, self.CHUNK)
+            if not chunk:
+                line = bytes(self.buffer)
+                self.buffer.clear()
+                return line
+            self.buffer += chunk
+
+    def readinto(self, view) -> int:
+        if self.buffer:
+            n = min(len(view), len(self.buffer))
+            view[:n] = self.buffer[:n]
+            del self.buffer[:n]
+            return n
+        self._wait()
+        return os.readv(self.fd, [view])
+
+
+class _Worker:
+    """A persistent `spade-cli --serve` process talking over its stdin/stdout pipes."""
+
+    def __init__(self, wire: str):
+        self.wire = wire
+        self.proc = subprocess.Popen(
+            [str(SPADE_CLI), "--serve", "--format", wire],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+        )
+        self.reader = _PipeReader(self.proc.stdout.fileno())
+
+    def alive(self) -> bool:
+        return self.proc.poll() is None
+
+    def request(self, payload: bytes, timeout: float):
+        if self.wire == "json":
+            payload += b"\n"
+        self.proc.stdin.write(payload)
+        self.proc.stdin.flush()
+
+        # The timeout covers the whole reply
+        self.reader.deadline = time.monotonic() + timeout
+        try:
+            if self.wire == "json":
+                line = self.reader.readline()
+                if not line:
+                    raise RuntimeError("Spade CLI server exited unexpectedly")
+                return line
+            return _read_binary(self.reader)
+        except TimeoutError:
+            self.close()
+            raise RuntimeError(f"Spade CLI timed out after {timeout} s") from None
+
+    def close(self):
+        if self.alive():
+            self.proc.stdin.close()
+            try:
+                self.proc.wait(timeout=1)
+            except subprocess.TimeoutExpired:
+                self.proc.kill()
+                self.proc.wait()
+
+
+class _WorkerSlot:
+    """Persistent workers (one per wire format) for one caller at a time. A worker
+    that crashed or timed out is dropped and replaced on the next request."""
+
+    def __init__(self):
+        self.workers: Dict[str, _Worker] = {}
+
+    def request(self, payload: bytes, wire: str, timeout: float):
+        worker = self.workers.get(wire)
+        if worker is None or not worker.alive():
+            worker = self.workers[wire] = _Worker(wire)
+        try:
+            return worker.request(payload, timeout)
+        except SpadeError:
+            raise
+        except (BrokenPipeError, RuntimeError):
+            worker.close()
+            del self.workers[wire]
+            raise
+
+    def close(self):
+        for worker in self.workers.values():
+            worker.close()
+        self.workers.clear()
+
+
+_default_slot = _WorkerSlot()
+_worker_lock = threading.Lock()
+
+# On SpadePool threads: `slot` and `timeout` of the job being run
+_pool_job = threading.local()
+
+
+def _shutdown_workers():
+    _default_slot.close()
+
+
+atexit.register(_shutdown_workers)
+
+
+def _in_pool() -> bool:
+    return getattr(_pool_job, "slot", None) is not None
+
+
+def _run_server(payload: bytes, wire: str):
+    """Send one request to a persistent worker, starting (or restarting) it if needed.
+
+    Inside a SpadePool job that is the pool thread's own worker; otherwise the
+    one worker shared by all callers.
+    """
+    if _in_pool():
+        return _pool_job.slot.request(payload, wire, _pool_job.timeout)
+    with _worker_lock:
+        return _default_slot.request(payload, wire, TIMEOUT)
+
+
+def _worker_pid(wire: Optional[str] = None) -> Optional[int]:
+    worker = _default_slot.workers.get(wire or WIRE_FORMAT)
+    return worker.proc.pid if worker is not None and worker.alive() else None
+
+
+def reset_peak_rss():
+    """Reset the persistent worker's peak RSS (Linux), so that the next
+    peak_rss_bytes() covers only the requests made in between."""
+    pid = _worker_pid()
+    if BACKEND == "cli" and USE_SERVER and pid is not None:
+        try:
+            with open(f"/proc/{pid}/clear_refs", "w") as f:
+                f.write("5")
+        except OSError:
+            pass
+
+
+def peak_rss_bytes() -> Optional[int]:
+    """Peak resident set size of the process doing the meshing.
+
+    That is the `--serve` worker (since its start or the last reset_peak_rss()),
+    the largest one-shot child so far, or this process with SPADE_BACKEND=native.
+    """
+    if BACKEND == "native":
+        return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+    if not USE_SERVER:
+        return resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss * 1024
+
+    pid = _worker_pid()
+    if pid is None:
+        return None
+    try:
+        with open(f"/proc/{pid}/status") as f:
+            for line in f:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1]) * 1024
+    except OSError:
+        pass
+    return None
+
+
+def _run_oneshot(payload: bytes, wire: str) -> bytes:
+    """Spawn a fresh spade-cli process for a single request."""
+    result = subprocess.run(
+        [str(SPADE_CLI), "--format", wire],
+        input=payload,
+        capture_output=True,
+        timeout=TIMEOUT,
+    )
+
+    if result.returncode != 0:
+        raise RuntimeError(f"Spade CLI failed: {result.stderr.decode(errors='replace')}")
+
+    return result.stdout
+
+
+def _triangulate_native(outer, inner_loops, **params):
+    """Mesh in-process through the spade_py extension; returns NumPy arrays owned by Rust."""
+    import numpy as np
+    import spade_py
+
+    def as_loop(loop):
+        return np.ascontiguousarray(loop, dtype=np.float64).reshape(-1, 2)
+
+    return spade_py.triangulate(as_loop(outer), [as_loop(loop) for loop in inner_loops], **params)
+
+
+def _backend_version() -> str:
+    """Identifies the meshing binary, so that rebuilding it invalidates the cache."""
+    if BACKEND == "native":
+        import spade_py
+        path = spade_py.__file__
+    else:
+        path = SPADE_CLI
+    st = os.stat(path)
+    return f"{BACKEND}:{st.st_size}:{st.st_mtime_ns}"
+
+
+def _cache_key(params: dict, outer, inner_loops) -> str:
+    """SHA-256 over the backend version, the parameters and the loop coordinates."""
+    import hashlib
+    import numpy as np
+
+    h = hashlib.sha256()
+    h.update(_backend_version().encode())
+    h.update(json.dumps(params, sort_keys=True).encode())
+    for loop in [outer, *inner_loops]:
+        # `+ 0.0` folds -0.0 into 0.0, which mesh identically
+        coords = np.asarray(loop, dtype="<f8").reshape(-1, 2) + 0.0
+        h.update(struct.pack("<Q", len(coords)))
+        h.update(coords.tobytes())
+    return h.hexdigest()
+
+
+def _cache_path(key: str) -> str:
+    return os.path.join(CACHE_DIR, key + _CACHE_SUFFIX)
+
+
+def _cache_load(key: str):
+    """Return the cached (mesh, info) as views into a read-only memory map, or None."""
+    import numpy as np
+
+    path = _cache_path(key)
+    try:
+        buf = np.memmap(path, dtype=np.uint8, mode="r")
+    except (FileNotFoundError, ValueError):
+        return None
+    # Eviction goes by modification time, so a hit counts as a use
+    try:
+        os.utime(path)
+    except OSError:
+        pass
+    mesh, info = _decode_binary(buf)
+    info["cache_hit"] = True
+    return mesh, info
+
+
+def _cache_store(key: str, mesh, info: dict, layout: int = 0):
+    """Write a result in the binary reply format with `layout`, atomically, then evict."""
+    import numpy as np
+
+    coord, dims, index = _layout_dtypes(layout)
+    points = np.ascontiguousarray(mesh[0], dtype=coord).reshape(-1, dims)
+    padding = bytes(_index_padding(layout, len(points)))
+    triangles = np.ascontiguousarray(mesh[1], dtype=index).reshape(-1, 3)
+    lines = np.ascontiguousarray(mesh[2], dtype=index).reshape(-1, 2)
+    # Timings describe the run that filled the cache, not a later hit
+    extra = json.dumps({k: v for k, v in info.items() if k != "timings"}).encode()
+    header = _RESPONSE_HEADER.pack(
+        _RESPONSE_MAGIC, 0, layout, len(points), len(triangles), len(lines), len(extra)
+    )
+
+    os.makedirs(CACHE_DIR, exist_ok=True)
+    fd, tmp = tempfile.mkstemp(dir=CACHE_DIR, suffix=".tmp")
+    try:
+        with os.fdopen(fd, "wb") as f:
+            for part in (header, points, padding, triangles, lines, extra):
+                f.write(part)
+        os.replace(tmp, _cache_path(key))
+    except BaseException:
+        try:
+            os.unlink(tmp)
+        except FileNotFoundError:
+            pass
+        raise
+    _cache_evict()
+
+
+def _cache_evict():
+    """Delete the least recently used entries until the cache fits CACHE_MAX_BYTES."""
+    entries = []
+    for entry in os.scandir(CACHE_DIR):
+        if entry.name.endswith(_CACHE_SUFFIX):
+            try:
+                st = entry.stat()
+            except FileNotFoundError:
+                continue
+            entries.append((st.st_mtime_ns, st.st_size, entry.path))
+
+    total = sum(size for _, size, _ in entries)
+    for _, size, path in sorted(entries):
+        if total <= CACHE_MAX_BYTES:
+            break
+        # Open memory maps of an unlinked entry stay valid
+        try:
+            os.unlink(path)
+        except FileNotFoundError:
+            pass
+        total -= size
+
+
+def _cli_params(
+    *,
+    maxh: Optional[float] = None,
+    quality: str = "default",
+    enforce_constraints: bool = False,
+    min_angle: Optional[float] = None,
+    exclude_holes: bool = True,
+    vtu_path: Optional[str] = None,
+    vtu_compress: bool = False,
+    return_mesh: bool = True,
+    return_info: bool = False,
+    clean_tolerance: Optional[float] = None,
+    simplify_tolerance: Optional[float] = None,
+    normalize: Optional[str] = None,
+    max_additional_vertices: Optional[int] = None,
+    deadline_ms: Optional[int] = None,
+    maxh_min: Optional[float] = None,
+    maxh_growth: Optional[float] = None,
+    coord_type: str = "f64",
+    dims: int = 3,
+    index_type: Optional[str] = None,
+    return_edges: bool = True,
+    triangles_only: bool = False,
+    renumber: Optional[str] = None,
+    return_permutation: bool = False,
+) -> dict:
+    """The CLI request fields for `triangulate()`'s meshing keyword arguments."""
+    params = {
+        "maxh": maxh,
+        "quality": quality,
+        "enforce_constraints": enforce_constraints,
+        "min_angle": min_angle,
+        "exclude_holes": exclude_holes,
+    }
+    if clean_tolerance is not None:
+        params["clean_tolerance"] = clean_tolerance
+    if simplify_tolerance is not None:
+        params["simplify_tolerance"] = simplify_tolerance
+    if normalize is not None:
+        params["normalize"] = normalize
+    if max_additional_vertices is not None:
+        params["max_additional_vertices"] = max_additional_vertices
+    if deadline_ms is not None:
+        params["deadline_ms"] = deadline_ms
+    if maxh_min is not None:
+        params["maxh_min"] = maxh_min
+    if maxh_growth is not None:
+        params["maxh_growth"] = maxh_growth
+    if coord_type != "f64":
+        params["coord_type"] = coord_type
+    if dims != 3:
+        params["dims"] = dims
+    if index_type is not None:
+        params["index_type"] = index_type
+    if not return_edges:
+        params["return_edges"] = False
+    if triangles_only:
+        params["triangles_only"] = True
+    if renumber is not None:
+        params["renumber"] = renumber
+    if return_permutation:
+        params["return_permutation"] = True
+    if return_info:
+        params["quality_metrics"] = True
+    if vtu_path is not None:
+        params.update(vtu=os.path.abspath(vtu_path), vtu_compress=vtu_compress, return_mesh=return_mesh)
+    return params
+
 
 def triangulate(
     outer: List[Tuple[float, float]],
@@ -20,7 +572,27 @@ def triangulate(
     quality: str = "default",
     enforce_constraints: bool = False,
     min_angle: Optional[float] = None,
-    exclude_holes: bool = True
+    exclude_holes: bool = True,
+    wire: Optional[str] = None,
+    vtu_path: Optional[str] = None,
+    vtu_compress: bool = False,
+    return_mesh: bool = True,
+    return_info: bool = False,
+    clean_tolerance: Optional[float] = None,
+    simplify_tolerance: Optional[float] = None,
+    normalize: Optional[str] = None,
+    max_additional_vertices: Optional[int] = None,
+    deadline_ms: Optional[int] = None,
+    maxh_min: Optional[float] = None,
+    maxh_growth: Optional[float] = None,
+    coord_type: str = "f64",
+    dims: int = 3,
+    index_type: Optional[str] = None,
+    return_edges: bool = True,
+    triangles_only: bool = False,
+    renumber: Optional[str] = None,
+    return_permutation: bool = False,
+    cache: Optional[bool] = None
 ) -> Tuple[List[Tuple[float, float, float]], List[Tuple[int, int, int]], List[Tuple[int, int]]]:
     """
     Triangulate a polygon using Spade.
@@ -33,42 +605,393 @@ def triangulate(
         enforce_constraints: If True, enforce PSLG edges as constraints
         min_angle: Minimum angle in degrees (overrides quality setting)
         exclude_holes: If True, exclude inner loops as holes; if False, triangulate them (default: True)
+        wire: "json" or "binary" (default: WIRE_FORMAT)
+        vtu_path: If set, spade-cli also writes the mesh to this .vtu file itself
+        vtu_compress: If True, zlib-compress the arrays in the .vtu file
+        return_mesh: If False, return empty arrays (use with vtu_path when only the file is needed)
+        return_info: If True, also compute mesh quality statistics in the CLI and
+            return them with the phase timings as a fourth element
+        clean_tolerance: If set, merge vertices closer than this and drop collinear
+            vertices within it before meshing (see spade-cli/src/cleanup.rs)
+        simplify_tolerance: If set, also simplify each loop with Douglas-Peucker
+        normalize: "center" to mesh with the bounding box centred on the origin,
+            "unit" to also scale it to unit size; the mesh comes back in input
+            coordinates (see spade-cli/src/frame.rs)
+        max_additional_vertices: If set, stop refinement after inserting this many vertices
+        deadline_ms: If set, stop refinement this many milliseconds after insertion
+            started. With either budget the mesh built so far is returned, and
+            info["refinement"] says whether it was truncated and holds its worst
+            minimum angle and largest triangle area
+        maxh_min: If set with maxh, grade the target edge length from maxh_min at
+            the loops up to maxh away from them (see spade-cli/src/sizing.rs)
+        maxh_growth: Target edge length increase per unit distance from the loops
+        coord_type: "f64" (default) or "f32" point coordinates in the reply
+        dims: 3 (default, z = 0) or 2 point columns
+        index_type: "u32" or "u64" index arrays (default: u32 from the CLI,
+            the platform's usize from SPADE_BACKEND=native)
+        return_edges: If False, lines comes back empty
+        triangles_only: If True, only the triangles come back (points and lines empty)
+        renumber: "hilbert" or "rcm" (reverse Cuthill-McKee) to renumber the
+            vertices for solver locality, with the triangles and lines sorted to
+            match (default: triangulation order, see spade-cli/src/renumber.rs)
+        return_permutation: If True (with return_info), info["vertex_permutation"]
+            and info["triangle_permutation"] give each vertex's and triangle's
+            number without renumbering
+        cache: Look the result up in (and write it back to) the SPADE_CACHE
+            directory. None (default) uses the cache whenever SPADE_CACHE is set,
+            False bypasses it. Requests with vtu_path or deadline_ms are never
+            cached. Hits are NumPy arrays viewing a read-only numpy.memmap of the
+            cache entry, and their info has "cache_hit" set and no "timings"
 
     Returns:
         Tuple of:
         - points_xyz: List of (x, y, z) vertex coordinates (z=0.0)
         - triangles: List of (i, j, k) triangle vertex indices
         - lines: List of (i, j) constraint edge indices
+        - info: Only with return_info; dict with the CLI's "quality" block and
+          per-phase "timings" (CLI phases plus encode_sec, ipc_sec, decode_sec)
+
+        With the binary wire format these are NumPy arrays of shape (N, 3), (M, 3)
+        and (K, 2) that view the reply buffer directly; with SPADE_BACKEND=native
+        they are NumPy arrays whose buffers are owned by the Rust extension.
     """
+    if cache and CACHE_DIR is None:
+        raise ValueError("cache=True needs the SPADE_CACHE directory to be set")
+    key = None
+    layout = _layout_bits(coord_type, dims, index_type or "u32")
+    if (cache is None or cache) and CACHE_DIR is not None and vtu_path is None and deadline_ms is None:
+        key = _cache_key({
+            "maxh": maxh, "quality": quality, "enforce_constraints": enforce_constraints,
+            "min_angle": min_angle, "exclude_holes": exclude_holes, "quality_metrics": return_info,
+            "clean_tolerance": clean_tolerance, "simplify_tolerance": simplify_tolerance,
+            "normalize": normalize, "max_additional_vertices": max_additional_vertices, "maxh_min": maxh_min,
+            "maxh_growth": maxh_growth, "coord_type": coord_type, "dims": dims,
+            "index_type": index_type, "return_edges": return_edges, "triangles_only": triangles_only,
+            "renumber": renumber, "return_permutation": return_permutation,
+        }, outer, inner_loops)
+        hit = _cache_load(key)
+        if hit is not None:
+            mesh, info = hit
+            return (*mesh, info) if return_info else mesh
+
+    if BACKEND == "native":
+        result = _triangulate_native(
+            outer, inner_loops, maxh=maxh, quality=quality, enforce_constraints=enforce_constraints,
+            min_angle=min_angle, exclude_holes=exclude_holes,
+            vtu=vtu_path, vtu_compress=vtu_compress, return_mesh=return_mesh,
+            return_info=return_info, clean_tolerance=clean_tolerance,
+            simplify_tolerance=simplify_tolerance, normalize=normalize,
+            max_additional_vertices=max_additional_vertices,
+            deadline_ms=deadline_ms, maxh_min=maxh_min, maxh_growth=maxh_growth,
+            coord_type=coord_type, dims=dims, index_type=index_type,
+            return_edges=return_edges, triangles_only=triangles_only,
+            renumber=renumber, return_permutation=return_permutation,
+        )
+        if key is not None:
+            _cache_store(key, result[:3], result[3] if return_info else {}, layout)
+        return result
+
+    wire = wire or WIRE_FORMAT
+    if wire not in ("json", "binary"):
+        raise ValueError(f"Unknown wire format: {wire}")
 
     # Prepare input for Rust CLI
-    input_data = {
+    params = _cli_params(
+        maxh=maxh, quality=quality, enforce_constraints=enforce_constraints, min_angle=min_angle,
+        exclude_holes=exclude_holes, vtu_path=vtu_path, vtu_compress=vtu_compress, return_mesh=return_mesh,
+        return_info=return_info, clean_tolerance=clean_tolerance, simplify_tolerance=simplify_tolerance,
+        normalize=normalize, max_additional_vertices=max_additional_vertices, deadline_ms=deadline_ms,
+        maxh_min=maxh_min, maxh_growth=maxh_growth, coord_type=coord_type, dims=dims, index_type=index_type,
+        return_edges=return_edges, triangles_only=triangles_only, renumber=renumber,
+        return_permutation=return_permutation,
+    )
+    encode = _encode_json if wire == "json" else _encode_binary
+    t0 = time.perf_counter()
+    payload = encode(params, outer, inner_loops)
+
+    # Call Rust CLI
+    t1 = time.perf_counter()
+    server = USE_SERVER or _in_pool()
+    reply = _run_server(payload, wire) if server else _run_oneshot(payload, wire)
+
+    # Parse output (the server path already decoded binary replies while reading them)
+    t2 = time.perf_counter()
+    if wire == "json":
+        mesh, info = _decode_json(reply)
+    else:
+        mesh, info = reply if server else _decode_binary(reply)
+    t3 = time.perf_counter()
+    if key is not None:
+        _cache_store(key, mesh, info, layout)
+
+    if not return_info:
+        return mesh
+    # Client-side phases; ipc_sec is the round trip minus the CLI's own work, i.e.
+    # process spawn, pipe transfer and reply serialization
+    timings = info.setdefault("timings", {})
+    timings["encode_sec"] = t1 - t0
+    timings["ipc_sec"] = (t2 - t1) - timings.get("parse_sec", 0.0) - timings.get("total_sec", 0.0)
+    timings["decode_sec"] = t3 - t2
+    return (*mesh, info)
+
+
+class SpadePool:
+    """
+    A pool of persistent `spade-cli --serve` workers that mesh concurrently.
+
+    Each of the `n_workers` threads (default: all cores) owns one worker process.
+    A job runs `triangulate()` on a free thread, so it takes the same keyword
+    arguments and returns the same result.
+
+    Backpressure: at most `max_pending` jobs (default: 2 * n_workers) are queued
+    or running, and `submit()` blocks until one finishes.
+
+    Timeouts and crashes: a job that exceeds its `timeout` (default: TIMEOUT) or
+    whose worker exits fails with RuntimeError. Only that worker is dropped, and
+    its thread starts a new one for its next job.
+
+    With SPADE_BACKEND=native the threads call the extension directly instead,
+    which releases the GIL while meshing.
+
+        with SpadePool(8) as pool:
+            for points, triangles, lines in pool.map(tiles, maxh=50.0):
+                ...
+    """
+
+    def __init__(
+        self,
+        n_workers: Optional[int] = None,
+        *,
+        max_pending: Optional[int] = None,
+        timeout: float = TIMEOUT,
+    ):
+        self.n_workers = n_workers or os.cpu_count() or 1
+        self.max_pending = max_pending or 2 * self.n_workers
+        self.timeout = timeout
+        self._slots: "queue.SimpleQueue[_WorkerSlot]" = queue.SimpleQueue()
+        self._all_slots = [_WorkerSlot() for _ in range(self.n_workers)]
+        for slot in self._all_slots:
+            self._slots.put(slot)
+        self._pending = threading.BoundedSemaphore(self.max_pending)
+        self._executor = ThreadPoolExecutor(self.n_workers, thread_name_prefix="spade-pool")
+
+    def _run(self, outer, inner_loops, timeout: float, kwargs: dict):
+        # At most n_workers jobs run at once, so a slot is always free here
+        slot = self._slots.get()
+        _pool_job.slot, _pool_job.timeout = slot, timeout
+        try:
+            return triangulate(outer, inner_loops, **kwargs)
+        finally:
+            _pool_job.slot = None
+            self._slots.put(slot)
+
+    def _submit_acquired(self, outer, inner_loops, timeout: Optional[float], kwargs: dict) -> Future:
+        """Submit a job whose `_pending` permit the caller already holds."""
+        try:
+            future = self._executor.submit(self._run, outer, inner_loops, timeout or self.timeout, kwargs)
+        except BaseException:
+            self._pending.release()
+            raise
+        future.add_done_callback(lambda _: self._pending.release())
+        return future
+
+    def submit(self, outer, inner_loops, *, timeout: Optional[float] = None, **kwargs) -> Future:
+        """Queue one `triangulate(outer, inner_loops, **kwargs)` call, blocking while
+        `max_pending` jobs are outstanding. Returns a concurrent.futures.Future."""
+        self._pending.acquire()
+        return self._submit_acquired(outer, inner_loops, timeout, kwargs)
+
+    def map(self, geometries, *, timeout: Optional[float] = None, **kwargs) -> Iterator:
+        """
+        Mesh every `(outer, inner_loops)` of `geometries` with the same keyword
+        arguments and yield the results in input order.
+
+        Jobs are submitted as results are consumed, so a long (or lazy) input
+        never has more than `max_pending` jobs in flight or waiting to be read.
+        """
+        futures = deque()
+        for outer, inner_loops in geometries:
+            if len(futures) >= self.max_pending:
+                yield futures.popleft().result()
+            futures.append(self.submit(outer, inner_loops, timeout=timeout, **kwargs))
+        while futures:
+            yield futures.popleft().result()
+
+    def close(self):
+        """Wait for the outstanding jobs, then stop the workers."""
+        self._executor.shutdown(wait=True)
+        for slot in self._all_slots:
+            slot.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+_default_pool: Optional[SpadePool] = None
+_default_pool_lock = threading.Lock()
+
+
+def _shared_pool() -> SpadePool:
+    global _default_pool
+    with _default_pool_lock:
+        if _default_pool is None:
+            _default_pool = SpadePool()
+            atexit.register(_default_pool.close)
+        return _default_pool
+
+
+async def triangulate_async(outer, inner_loops, *, pool: Optional[SpadePool] = None,
+                            timeout: Optional[float] = None, **kwargs):
+    """
+    `await`able `triangulate()`: runs the job on `pool` (default: one shared
+    SpadePool over all cores) without blocking the event loop, including while
+    waiting for room under the pool's `max_pending`.
+    """
+    pool = pool or _shared_pool()
+    loop = asyncio.get_running_loop()
+    if not pool._pending.acquire(blocking=False):
+        waiter = loop.run_in_executor(None, pool._pending.acquire)
+        try:
+            await asyncio.shield(waiter)
+        except asyncio.CancelledError:
+            # Hand back the permit the waiting thread still takes
+            waiter.add_done_callback(lambda _: pool._pending.release())
+            raise
+    return await asyncio.wrap_future(pool._submit_acquired(outer, inner_loops, timeout, kwargs))
+
+
+# Batch replies carry the mesh alone, so return_info has no place in a job
+_BATCH_KEYS = set(inspect.signature(_cli_params).parameters) - {"return_info"}
+
+
+def triangulate_batch(
+    outer: List[Tuple[float, float]],
+    inner_loops: List[List[Tuple[float, float]]],
+    jobs: List[dict],
+    *,
+    threads: Optional[int] = None,
+) -> Iterator[Tuple[object, float, tuple]]:
+    """
+    Mesh one geometry with several parameter sets in a single `spade-cli --batch` run.
+
+    Each job is a dict of `triangulate()` keyword arguments plus an optional "id"
+    (defaults to its position). All of them are supported except `wire`, `cache`
+    and `return_info`; other keys raise ValueError. Jobs run in parallel on all
+    cores (or `threads`).
+
+    Yields (id, elapsed_sec, (points, triangles, lines)) in completion order, where
+    elapsed_sec is the time spent meshing inside the CLI.
+    """
+    def job_request(i, job):
+        options = {key: value for key, value in job.items() if key != "id"}
+        unknown = options.keys() - _BATCH_KEYS
+        if unknown:
+            raise ValueError(f"Unsupported batch job keys: {', '.join(sorted(unknown))}")
+        return {"id": job.get("id", i), **_cli_params(**options)}
+
+    request = {
         "outer": [[x, y] for x, y in outer],
         "inner_loops": [[[x, y] for x, y in loop] for loop in inner_loops],
-        "maxh": maxh,
+        "jobs": [job_request(i, job) for i, job in enumerate(jobs)],
+        "threads": threads,
+    }
+
+    for reply in _stream_json("--batch", request):
+        if "error" in reply:
+            raise RuntimeError(f"Spade CLI job {reply['id']} failed: {reply['error']}")
+        yield reply["id"], reply["elapsed_sec"], _mesh_from_json(reply["result"])
+
+
+def triangulate_levels(
+    outer: List[Tuple[float, float]],
+    inner_loops: List[List[Tuple[float, float]]],
+    levels: List[float],
+    *,
+    quality: str = "default",
+    enforce_constraints: bool = False,
+    min_angle: Optional[float] = None,
+    exclude_holes: bool = True,
+) -> Iterator[Tuple[float, float, tuple]]:
+    """
+    Coarse-to-fine meshing with `spade-cli --levels`: the CDT is built once and
+    refined to each maxh in `levels` (largest first), reusing the previous level.
+
+    Yields (maxh, elapsed_sec, (points, triangles, lines)) per level, where
+    elapsed_sec is the CLI time since the previous level (the first includes the build).
+    """
+    request = {
+        "outer": [[x, y] for x, y in outer],
+        "inner_loops": [[[x, y] for x, y in loop] for loop in inner_loops],
+        "levels": list(levels),
         "quality": quality,
         "enforce_constraints": enforce_constraints,
         "min_angle": min_angle,
         "exclude_holes": exclude_holes,
     }
+    for reply in _stream_json("--levels", request):
+        yield reply["maxh"], reply["elapsed_sec"], _mesh_from_json(reply["result"])
 
-    # Call Rust CLI
+
+def triangulate_testcase(
+    path: str,
+    *,
+    maxh: Optional[float] = None,
+    quality: str = "default",
+    enforce_constraints: bool = False,
+    min_angle: Optional[float] = None,
+    exclude_holes: bool = True,
+    wire: Optional[str] = None,
+) -> Tuple[List[Tuple[float, float, float]], List[Tuple[int, int, int]], List[Tuple[int, int]]]:
+    """
+    Mesh a testcase file (the harness' load_testcase() format) with
+    `spade-cli --testcase`, which reads and parses the file itself, so the
+    coordinates never pass through Python or JSON.
+
+    Returns (points, triangles, lines) like triangulate().
+    """
+    wire = wire or WIRE_FORMAT
+    params = {
+        "maxh": maxh,
+        "quality": quality,
+        "enforce_constraints": enforce_constraints,
+        "min_angle": min_angle,
+        "exclude_holes": exclude_holes,
+    }
     result = subprocess.run(
-        [str(SPADE_CLI)],
-        input=json.dumps(input_data),
+        [str(SPADE_CLI), "--testcase", os.path.abspath(path), "--params", json.dumps(params), "--format", wire],
         capture_output=True,
-        text=True,
-        timeout=300,
+        timeout=TIMEOUT,
     )
-
     if result.returncode != 0:
-        raise RuntimeError(f"Spade CLI failed: {result.stderr}")
+        raise RuntimeError(f"Spade CLI failed: {result.stderr.decode(errors='replace')}")
+    decode = _decode_json if wire == "json" else _decode_binary
+    mesh, _ = decode(result.stdout)
+    return mesh
 
-    # Parse output
-    output = json.loads(result.stdout)
 
-    points = [tuple(p) for p in output["points"]]
-    triangles = [tuple(t) for t in output["triangles"]]
-    lines = [tuple(e) for e in output["constraint_edges"]]
+def _stream_json(mode: str, request: dict) -> Iterator[dict]:
+    """Run a streaming CLI mode and yield its JSON reply lines as they arrive."""
+    proc = subprocess.Popen(
+        [str(SPADE_CLI), mode],
+        stdin=subprocess.PIPE,
+        stdout=subprocess.PIPE,
+    )
+    try:
+        # The CLI reads the whole request before it starts writing replies
+        proc.stdin.write(json.dumps(request).encode())
+        proc.stdin.close()
 
-    return points, triangles, lines
+        for line in proc.stdout:
+            yield json.loads(line)
+
+        if proc.wait(timeout=TIMEOUT) != 0:
+            raise RuntimeError(f"Spade CLI {mode} run failed")
+    finally:
+        # Also reached when the caller stops iterating early
+        if proc.poll() is None:
+            proc.kill()
+            proc.wait()
+        proc.stdout.close()
@@ -7,11 +7,13 @@ import argparse
 import json
 import time
 import platform
+import random
 import subprocess
 import sys
 from pathlib import Path
 from typing import List, Tuple, Optional
 import importlib.util
+import inspect
 
 try:
     import numpy as np
@@ -36,6 +38,56 @@ def load_testcase(filepath: str) -> Tuple[List[Tuple[float, float]], List[List[T
     return outer, inner_loops
 
 
+def city_grid(outer: List[Tuple[float, float]], inner_loops: List[List[Tuple[float, float]]], n: int,
+              seed: int = 0) -> Tuple[List[Tuple[float, float]], List[List[Tuple[float, float]]]]:
+    """Tile the testcase block into an n x n city for the Test E scaling runs.
+
+    Every copy of the inner loops is rotated by a random multiple of 90 degrees
+    about the block centre (180 degrees for non-square blocks) and shifted by a
+    random offset that keeps all of its loops inside its own block, so copies
+    differ but never intersect. The outer loop is the grid's bounding rectangle.
+    """
+    rng = random.Random(seed)
+    xs, ys = [p[0] for p in outer], [p[1] for p in outer]
+    x0, x1, y0, y1 = min(xs), max(xs), min(ys), max(ys)
+    w, h = x1 - x0, y1 - y0
+    cx, cy = (x0 + x1) / 2, (y0 + y1) / 2
+    step = 1 if w == h else 2
+
+    def rotate(p, quarter_turns):
+        x, y = p[0] - cx, p[1] - cy
+        for _ in range(quarter_turns):
+            x, y = -y, x
+        return cx + x, cy + y
+
+    grid_loops = []
+    for i in range(n):
+        for j in range(n):
+            turns = step * rng.randrange(4 // step)
+            rotated = [[rotate(p, turns) for p in loop] for loop in inner_loops]
+            pts = [p for loop in rotated for p in loop]
+            dx = rng.uniform(x0 - min(p[0] for p in pts), x1 - max(p[0] for p in pts)) if pts else 0.0
+            dy = rng.uniform(y0 - min(p[1] for p in pts), y1 - max(p[1] for p in pts)) if pts else 0.0
+            ox, oy = i * w + dx, j * h + dy
+            grid_loops.extend([[(x + ox, y + oy) for x, y in loop] for loop in rotated])
+
+    grid_outer = [(x0, y0), (x0 + n * w, y0), (x0 + n * w, y0 + n * h), (x0, y0 + n * h)]
+    return grid_outer, grid_loops
+
+
+def scaling_exponents(rows: List[dict]) -> List[Optional[float]]:
+    """Local log-log slope of time against input vertices between consecutive
+    Test E rows (1.0 is linear scaling); None for the first row."""
+    exponents = [None]
+    for prev, row in zip(rows, rows[1:]):
+        if prev['time_sec'] > 0 and row['time_sec'] > 0 and row['input_vertices'] > prev['input_vertices']:
+            exponents.append(float(np.log(row['time_sec'] / prev['time_sec'])
+                                   / np.log(row['input_vertices'] / prev['input_vertices'])))
+        else:
+            exponents.append(None)
+    return exponents
+
+
 def get_system_meta() -> dict:
     """Gather system metadata."""
     meta = {
@@ -65,62 +117,47 @@ def get_system_meta() -> dict:
     return meta
 
 
+# Histogram bins for compute_mesh_quality() and quality_from_block()
+ANGLE_BINS = [0, 10, 20, 30, 40, 50, 60, 90]
+AR_BINS = [1, 2, 5, 10, 20, 50, 100, np.inf]
+
+
 def compute_mesh_quality(points: List[Tuple[float, float, float]],
                          triangles: List[Tuple[int, int, int]]) -> dict:
-    """Compute mesh quality metrics."""
-    points_np = np.array(points)
-    triangles_np = np.array(triangles)
-
-    min_angles = []
-    aspect_ratios = []
-    areas = []
-
-    for tri in triangles_np:
-        # Get triangle vertices
-        p0, p1, p2 = points_np[tri[0]], points_np[tri[1]], points_np[tri[2]]
-
-        # Compute edge vectors
-        e0 = p1 - p0
-        e1 = p2 - p1
-        e2 = p0 - p2
-
-        # Edge lengths
-        l0 = np.linalg.norm(e0)
-        l1 = np.linalg.norm(e1)
-        l2 = np.linalg.norm(e2)
-
-        # Triangle area (2D cross product)
-        area = 0.5 * abs(e0[0] * (-e2[1]) - e0[1] * (-e2[0]))
-        areas.append(area)
-
-        # Angles using law of cosines
-        if l0 > 0 and l1 > 0 and l2 > 0:
-            angle0 = np.arccos(np.clip((l0**2 + l2**2 - l1**2) / (2 * l0 * l2), -1, 1))
-            angle1 = np.arccos(np.clip((l0**2 + l1**2 - l2**2) / (2 * l0 * l1), -1, 1))
-            angle2 = np.arccos(np.clip((l1**2 + l2**2 - l0**2) / (2 * l1 * l2), -1, 1))
-
-            min_angle_rad = min(angle0, angle1, angle2)
-            min_angles.append(np.degrees(min_angle_rad))
-
-            # Aspect ratio: ratio of longest edge to shortest altitude
-            # altitude = 2 * area / base
-            min_altitude = 2 * area / max(l0, l1, l2)
-            max_edge = max(l0, l1, l2)
-            aspect_ratio = max_edge / min_altitude if min_altitude > 0 else float('inf')
-            aspect_ratios.append(aspect_ratio)
+    """Compute mesh quality metrics (vectorized over all triangles)."""
+    points_np = np.asarray(points, dtype=float).reshape(-1, 3)
+    triangles_np = np.asarray(triangles, dtype=np.int64).reshape(-1, 3)
+
+    # Edge vectors and lengths
+    p0, p1, p2 = (points_np[triangles_np[:, i]] for i in range(3))
+    e0 = p1 - p0
+    e1 = p2 - p1
+    e2 = p0 - p2
+    l0 = np.linalg.norm(e0, axis=1)
+    l1 = np.linalg.norm(e1, axis=1)
+    l2 = np.linalg.norm(e2, axis=1)
+
+    # Triangle area (2D cross product)
+    areas_np = 0.5 * np.abs(e0[:, 0] * (-e2[:, 1]) - e0[:, 1] * (-e2[:, 0]))
+
+    # Angles using law of cosines, for triangles without zero-length edges
+    valid = (l0 > 0) & (l1 > 0) & (l2 > 0)
+    l0, l1, l2, valid_areas = l0[valid], l1[valid], l2[valid], areas_np[valid]
+    angle0 = np.arccos(np.clip((l0**2 + l2**2 - l1**2) / (2 * l0 * l2), -1, 1))
+    angle1 = np.arccos(np.clip((l0**2 + l1**2 - l2**2) / (2 * l0 * l1), -1, 1))
+    angle2 = np.arccos(np.clip((l1**2 + l2**2 - l0**2) / (2 * l1 * l2), -1, 1))
+    min_angles_np = np.degrees(np.minimum(np.minimum(angle0, angle1), angle2))
+
+    # Aspect ratio: ratio of longest edge to shortest altitude
+    # altitude = 2 * area / base
+    max_edge = np.maximum(np.maximum(l0, l1), l2)
+    min_altitude = 2 * valid_areas / max_edge
+    with np.errstate(divide='ignore'):
+        aspect_ratios_np = np.where(min_altitude > 0, max_edge / min_altitude, np.inf)
 
     # Compute distributions
-    min_angles_np = np.array(min_angles)
-    aspect_ratios_np = np.array(aspect_ratios)
-    areas_np = np.array(areas)
-
-    # Angle distribution bins
-    angle_bins = [0, 10, 20, 30, 40, 50, 60, 90]
-    angle_hist, _ = np.histogram(min_angles_np, bins=angle_bins)
-
-    # Aspect ratio distribution bins
-    ar_bins = [1, 2, 5, 10, 20, 50, 100, np.inf]
-    ar_hist, _ = np.histogram(aspect_ratios_np, bins=ar_bins)
+    angle_hist, _ = np.histogram(min_angles_np, bins=ANGLE_BINS)
+    ar_hist, _ = np.histogram(aspect_ratios_np, bins=AR_BINS)
 
     return {
         'num_triangles': len(triangles),
@@ -131,7 +168,7 @@ def compute_mesh_quality(points: List[Tuple[float, float, float]],
             'mean': float(np.mean(min_angles_np)) if len(min_angles_np) > 0 else 0,
             'median': float(np.median(min_angles_np)) if len(min_angles_np) > 0 else 0,
             'distribution': {
-                f'{angle_bins[i]}-{angle_bins[i+1]}°': int(angle_hist[i])
+                f'{ANGLE_BINS[i]}-{ANGLE_BINS[i+1]}°': int(angle_hist[i])
                 for i in range(len(angle_hist))
             }
         },
@@ -141,7 +178,7 @@ def compute_mesh_quality(points: List[Tuple[float, float, float]],
             'mean': float(np.mean(aspect_ratios_np)) if len(aspect_ratios_np) > 0 else 0,
             'median': float(np.median(aspect_ratios_np)) if len(aspect_ratios_np) > 0 else 0,
             'distribution': {
-                f'{ar_bins[i]}-{ar_bins[i+1]}': int(ar_hist[i])
+                f'{AR_BINS[i]}-{AR_BINS[i+1]}': int(ar_hist[i])
                 for i in range(len(ar_hist))
             }
         },
@@ -154,6 +191,30 @@ def compute_mesh_quality(points: List[Tuple[float, float, float]],
     }
 
 
+def quality_from_block(block: dict) -> dict:
+    """Convert a `quality` block computed by the adapter's backend into the
+    layout of compute_mesh_quality(). Non-finite values arrive as null."""
+    def value(v):
+        return float('inf') if v is None else float(v)
+
+    def summary(stats, bins=None, unit=''):
+        out = {key: value(stats[key]) for key in ('min', 'max', 'mean', 'median')}
+        if bins is not None:
+            out['distribution'] = {
+                f'{bins[i]}-{bins[i+1]}{unit}': int(count)
+                for i, count in enumerate(stats['histogram'])
+            }
+        return out
+
+    return {
+        'num_triangles': block['num_triangles'],
+        'total_area': value(block['total_area']),
+        'min_angle': summary(block['min_angle'], ANGLE_BINS, '°'),
+        'aspect_ratio': summary(block['aspect_ratio'], AR_BINS),
+        'area': summary(block['area']),
+    }
+
+
 def write_vtu(filepath: str, points: List[Tuple[float, float, float]],
               triangles: List[Tuple[int, int, int]],
               lines: Optional[List[Tuple[int, int]]] = None):
@@ -161,35 +222,179 @@ def write_vtu(filepath: str, points: List[Tuple[float, float, float]],
     points_array = np.array(points, dtype=float)
 
     cells = [("triangle", np.array(triangles, dtype=int))]
-    if lines:
+    if lines is not None and len(lines) > 0:
         cells.append(("line", np.array(lines, dtype=int)))
 
     mesh = meshio.Mesh(points=points_array, cells=cells)
     meshio.write(filepath, mesh)
 
 
-def run_benchmark(adapter_module, outer, inner_loops, maxh, quality, enforce_constraints, repeats=3):
-    """Run triangulation benchmark with timing."""
+def summarize_samples(samples: List[float]) -> dict:
+    """Distribution of repeated timings, all in seconds."""
+    arr = np.asarray(samples, dtype=float)
+    return {
+        'median_sec': float(np.median(arr)),
+        'p5_sec': float(np.percentile(arr, 5)),
+        'p95_sec': float(np.percentile(arr, 95)),
+        'stddev_sec': float(np.std(arr, ddof=1)) if len(arr) > 1 else 0.0,
+        'samples_sec': [float(x) for x in arr],
+    }
+
+
+def run_benchmark(adapter_module, outer, inner_loops, maxh, quality, enforce_constraints, repeats=3,
+                  warmup=0, min_duration=0.0, options=None, vtu_path=None):
+    """Run triangulation benchmark with timing.
+
+    After `warmup` untimed calls, the case is timed at least `repeats` times and
+    until the timed calls add up to `min_duration` seconds. The best time is
+    returned; the distribution of all samples is in info['stats']. `options` are
+    extra triangulate() keyword arguments, passed only if the adapter accepts them.
+
+    If the adapter's triangulate() accepts return_info, the quality statistics and
+    per-phase timings are taken from the backend's reply, and the time it reports
+    for computing the statistics is not counted. Returns
+    (points, triangles, lines, best_time, info), where info holds the 'quality'
+    (in compute_mesh_quality() layout), 'timings' and 'memory' of the best run and
+    the meshing process' 'peak_rss_bytes' over all repeats, if provided.
+
+    With `vtu_path`, the adapter's backend writes the mesh to that file itself
+    during one of these calls, so the case is not meshed again for the file:
+    the first warmup call, or the first timed repeat (whose time then includes
+    the write) without warmup. info['vtu_written'] is set when it did.
+    """
+    native_info = 'return_info' in inspect.signature(adapter_module.triangulate).parameters
+    accepted = inspect.signature(adapter_module.triangulate).parameters
+    # Benchmark calls must mesh every time, so any result cache is bypassed
+    extra = {key: value for key, value in {'cache': False, **(options or {})}.items() if key in accepted}
+    if native_info:
+        extra['return_info'] = True
     best_time = float('inf')
     best_result = None
+    best_info = {}
+    samples = []
 
-    for _ in range(repeats):
-        start = time.perf_counter()
-        result = adapter_module.triangulate(
+    native_vtu = vtu_path is not None and 'vtu_path' in accepted
+
+    def call(**vtu):
+        return adapter_module.triangulate(
             outer=outer,
             inner_loops=inner_loops,
             maxh=maxh,
             quality=quality,
-            enforce_constraints=enforce_constraints
+            enforce_constraints=enforce_constraints,
+            **extra,
+            **vtu
         )
+
+    for i in range(warmup):
+        call(**({'vtu_path': vtu_path} if native_vtu and i == 0 else {}))
+    if hasattr(adapter_module, 'reset_peak_rss'):
+        adapter_module.reset_peak_rss()
+
+    while len(samples) < max(repeats, 1) or sum(samples) < min_duration:
+        vtu = {'vtu_path': vtu_path} if native_vtu and warmup == 0 and not samples else {}
+        start = time.perf_counter()
+        result = call(**vtu)
         elapsed = time.perf_counter() - start
 
+        info = {}
+        if native_info:
+            *result, info = result
+            if info.get('quality') is not None:
+                elapsed -= info['quality'].get('elapsed_sec') or 0.0
+        samples.append(elapsed)
+
         if elapsed < best_time:
             best_time = elapsed
             best_result = result
+            best_info = info
 
     points, triangles, lines = best_result
-    return points, triangles, lines, best_time
+    info = {'stats': summarize_samples(samples)}
+    if best_info.get('quality') is not None:
+        info['quality'] = quality_from_block(best_info['quality'])
+    for key in ('timings', 'memory'):
+        if best_info.get(key) is not None:
+            info[key] = best_info[key]
+    if hasattr(adapter_module, 'peak_rss_bytes'):
+        info['peak_rss_bytes'] = adapter_module.peak_rss_bytes()
+    if native_vtu:
+        info['vtu_written'] = True
+    return points, triangles, lines, best_time, info
+
+
+# Timing distribution columns; net_median_sec subtracts the empty-request overhead
+STAT_COLUMNS = [
+    'time_median_sec', 'time_p5_sec', 'time_p95_sec', 'time_stddev_sec', 'overhead_sec', 'net_median_sec',
+]
+
+# Input size and memory columns (Test E scaling)
+SCALE_COLUMNS = ['input_vertices', 'peak_rss_bytes', 'scaling_exponent']
+
+# Per-phase columns recorded from the adapter's timings, when it reports them
+PHASE_COLUMNS = [
+    'encode_sec', 'parse_sec', 'cleanup_sec', 'insert_vertices_sec', 'insert_constraints_sec',
+    'refine_sec', 'extract_sec', 'ipc_sec', 'decode_sec', 'vertices_added_by_refinement',
+]
+
+
+def info_columns(info: dict) -> dict:
+    """Result fields from a run_benchmark() info dict: the timing distribution, the
+    PHASE_COLUMNS, peak RSS and per-phase allocation statistics (None where not
+    reported)."""
+    timings = info.get('timings') or {}
+    stats = info.get('stats') or {}
+    return {
+        **{f'time_{key}': stats.get(key) for key in ('median_sec', 'p5_sec', 'p95_sec', 'stddev_sec')},
+        'samples_sec': stats.get('samples_sec'),
+        **{column: timings.get(column) for column in PHASE_COLUMNS},
+        'peak_rss_bytes': info.get('peak_rss_bytes'),
+        'memory': info.get('memory'),
+    }
+
+
+def run_batch_benchmark(adapter_module, outer, inner_loops, sizes, quality, enforce_constraints, repeats=3):
+    """Run a whole size sweep as one parallel batch per repeat.
+
+    Per-size times are the meshing times reported by the adapter for each job, so
+    they exclude the shared IPC cost; the best batch wall time is returned separately.
+    """
+    jobs = [
+        {'id': i, 'maxh': size, 'quality': quality, 'enforce_constraints': enforce_constraints}
+        for i, size in enumerate(sizes)
+    ]
+    best = {}
+    best_wall = float('inf')
+
+    for _ in range(repeats):
+        start = time.perf_counter()
+        for job_id, elapsed, (points, triangles, lines) in adapter_module.triangulate_batch(
+                outer, inner_loops, jobs):
+            if job_id not in best or elapsed < best[job_id][3]:
+                best[job_id] = (points, triangles, lines, elapsed)
+        best_wall = min(best_wall, time.perf_counter() - start)
+
+    return {size: best[i] for i, size in enumerate(sizes)}, best_wall
+
+
+def run_levels_benchmark(adapter_module, outer, inner_loops, sizes, quality, enforce_constraints, repeats=3):
+    """Run a whole size sweep as one coarse-to-fine refinement per repeat.
+
+    Per-size times are the incremental cost of each level on top of the previous
+    one; the best total wall time for the whole sweep is returned separately.
+    """
+    best = {}
+    best_wall = float('inf')
+
+    for _ in range(repeats):
+        start = time.perf_counter()
+        for maxh, elapsed, (points, triangles, lines) in adapter_module.triangulate_levels(
+                outer, inner_loops, sizes, quality=quality, enforce_constraints=enforce_constraints):
+            if maxh not in best or elapsed < best[maxh][3]:
+                best[maxh] = (points, triangles, lines, elapsed)
+        best_wall = min(best_wall, time.perf_counter() - start)
+
+    return best, best_wall
 
 
 def main():
@@ -201,6 +406,31 @@ def main():
     parser.add_argument('--sizes', nargs='+', type=float, default=[100, 50, 20, 10, 5, 2, 1],
                        help='Size parameters for sweep')
     parser.add_argument('--repeats', type=int, default=3, help='Number of timing repeats')
+    parser.add_argument('--warmup', type=int, default=1, help='Untimed warm-up calls per case')
+    parser.add_argument('--min-duration', type=float, default=0.0,
+                       help='Keep repeating each case until its timed calls add up to this many seconds')
+    parser.add_argument('--batch-sweep', action='store_true',
+                       help='Run Test D as one parallel batch if the adapter provides triangulate_batch()')
+    parser.add_argument('--progressive-sweep', action='store_true',
+                       help='Run Test D as one coarse-to-fine refinement if the adapter provides triangulate_levels()')
+    parser.add_argument('--clean-tolerance', type=float, default=None,
+                       help='City cases: merge/drop near-duplicate and collinear vertices within this distance '
+                            '(adapters that accept clean_tolerance)')
+    parser.add_argument('--simplify-tolerance', type=float, default=None,
+                       help='City cases: Douglas-Peucker tolerance (adapters that accept simplify_tolerance)')
+    parser.add_argument('--normalize', choices=['center', 'unit'], default=None,
+                       help='City cases: mesh in a frame centred on the bounding box, optionally scaled to unit size '
+                            '(adapters that accept normalize)')
+    parser.add_argument('--graded', type=float, default=None, metavar='FRACTION',
+                       help='City cases: grade the target size from FRACTION * maxh at the loops up to maxh '
+                            '(adapters that accept maxh_min)')
+    parser.add_argument('--maxh-growth', type=float, default=None,
+                       help='With --graded: target size increase per unit distance from the loops')
+    parser.add_argument('--scale-grids', nargs='*', type=int, default=[1, 2, 4, 8, 16, 32],
+                       help='Test E: mesh N x N tilings of the testcase for each N (none to skip)')
+    parser.add_argument('--scale-maxh', type=float, default=100.0, help='Test E: fixed target size')
+    parser.add_argument('--native-vtu', action='store_true',
+                       help='Let the adapter write VTU files itself if its triangulate() accepts vtu_path')
 
     args = parser.parse_args()
 
@@ -208,6 +438,7 @@ def main():
     spec = importlib.util.spec_from_file_location("adapter", args.adapter)
     adapter = importlib.util.module_from_spec(spec)
     spec.loader.exec_module(adapter)
+    native_vtu = args.native_vtu and 'vtu_path' in inspect.signature(adapter.triangulate).parameters
 
     # Create output directory
     outdir = Path(args.outdir)
@@ -221,6 +452,21 @@ def main():
 
     # Load testcase
     outer, inner_loops = load_testcase(args.testcase)
+    city_options = {
+        key: value
+        for key, value in (('clean_tolerance', args.clean_tolerance), ('simplify_tolerance', args.simplify_tolerance),
+                           ('normalize', args.normalize))
+        if value is not None
+    }
+
+    def city_request(maxh):
+        """Adapter options for a city case at target size maxh."""
+        options = dict(city_options)
+        if args.graded is not None:
+            options['maxh_min'] = args.graded * maxh
+            if args.maxh_growth is not None:
+                options['maxh_growth'] = args.maxh_growth
+        return options
 
     # Results storage
     results = []
@@ -228,14 +474,38 @@ def main():
 
     print(f"Running benchmarks for {args.software}...")
 
+    # Calibration: an empty request costs only the adapter/IPC round trip, which
+    # is subtracted from the other cases as overhead_sec
+    print("Calibration: empty request")
+    overhead = None
+    try:
+        _, _, _, t, info = run_benchmark(
+            adapter, [], [], None, "default", False, args.repeats,
+            warmup=args.warmup, min_duration=args.min_duration
+        )
+        overhead = info['stats']['median_sec']
+        results.append({
+            'test': '0',
+            'description': 'empty_request',
+            'num_triangles': 0,
+            'time_sec': t,
+            'triangles_per_sec': 0,
+            **info_columns(info)
+        })
+    except Exception as e:
+        print(f"  Skipped, the adapter rejects empty input: {e}")
+
     # Test A: Unit square, defaults
     print("Test A: Unit square (default)")
     unit_square = [(0, 0), (1, 0), (1, 1), (0, 1)]
-    points, triangles, lines, t = run_benchmark(
-        adapter, unit_square, [], None, "default", False, args.repeats
+    points, triangles, lines, t, info = run_benchmark(
+        adapter, unit_square, [], None, "default", False, args.repeats,
+        warmup=args.warmup, min_duration=args.min_duration,
+        vtu_path=str(outdir / 'A_unit_square_default.vtu') if native_vtu else None
     )
-    write_vtu(str(outdir / 'A_unit_square_default.vtu'), points, triangles, lines)
-    quality = compute_mesh_quality(points, triangles)
+    if not info.get('vtu_written'):
+        write_vtu(str(outdir / 'A_unit_square_default.vtu'), points, triangles, lines)
+    quality = info.get('quality') or compute_mesh_quality(points, triangles)
     quality['test'] = 'A'
     quality['description'] = 'unit_square_default'
     quality_metrics.append(quality)
@@ -244,17 +514,21 @@ def main():
         'description': 'unit_square_default',
         'num_triangles': len(triangles),
         'time_sec': t,
-        'triangles_per_sec': len(triangles) / t if t > 0 else 0
+        'triangles_per_sec': len(triangles) / t if t > 0 else 0,
+        **info_columns(info)
     })
 
     # Test B: Unit square + inner polygon
     print("Test B: Unit square with inner polygon")
     inner_poly = [(0.3, 0.3), (0.7, 0.3), (0.7, 0.7), (0.3, 0.7)]
-    points, triangles, lines, t = run_benchmark(
-        adapter, unit_square, [inner_poly], None, "default", True, args.repeats
+    points, triangles, lines, t, info = run_benchmark(
+        adapter, unit_square, [inner_poly], None, "default", True, args.repeats,
+        warmup=args.warmup, min_duration=args.min_duration,
+        vtu_path=str(outdir / 'B_unit_square_with_inner_polygon.vtu') if native_vtu else None
     )
-    write_vtu(str(outdir / 'B_unit_square_with_inner_polygon.vtu'), points, triangles, lines)
-    quality = compute_mesh_quality(points, triangles)
+    if not info.get('vtu_written'):
+        write_vtu(str(outdir / 'B_unit_square_with_inner_polygon.vtu'), points, triangles, lines)
+    quality = info.get('quality') or compute_mesh_quality(points, triangles)
     quality['test'] = 'B'
     quality['description'] = 'unit_square_with_inner'
     quality_metrics.append(quality)
@@ -263,16 +537,20 @@ def main():
         'description': 'unit_square_with_inner',
         'num_triangles': len(triangles),
         'time_sec': t,
-        'triangles_per_sec': len(triangles) / t if t > 0 else 0
+        'triangles_per_sec': len(triangles) / t if t > 0 else 0,
+        **info_columns(info)
     })
 
     # Test C: City testcase
     print("Test C: City testcase (maxh=100)")
-    points, triangles, lines, t = run_benchmark(
-        adapter, outer, inner_loops, 100.0, "moderate", True, args.repeats
+    points, triangles, lines, t, info = run_benchmark(
+        adapter, outer, inner_loops, 100.0, "moderate", True, args.repeats,
+        warmup=args.warmup, min_duration=args.min_duration, options=city_request(100.0),
+        vtu_path=str(outdir / 'C_city_100.vtu') if native_vtu else None
     )
-    write_vtu(str(outdir / 'C_city_100.vtu'), points, triangles, lines)
-    quality = compute_mesh_quality(points, triangles)
+    if not info.get('vtu_written'):
+        write_vtu(str(outdir / 'C_city_100.vtu'), points, triangles, lines)
+    quality = info.get('quality') or compute_mesh_quality(points, triangles)
     quality['test'] = 'C'
     quality['description'] = 'city_maxh_100'
     quality_metrics.append(quality)
@@ -281,18 +559,37 @@ def main():
         'description': 'city_maxh_100',
         'num_triangles': len(triangles),
         'time_sec': t,
-        'triangles_per_sec': len(triangles) / t if t > 0 else 0
+        'triangles_per_sec': len(triangles) / t if t > 0 else 0,
+        **info_columns(info)
     })
 
     # Test D: Size sweep
     print("Test D: Size sweep")
+    sweep, sweep_wall = None, None
+    if args.batch_sweep and hasattr(adapter, 'triangulate_batch'):
+        sweep, sweep_wall = run_batch_benchmark(
+            adapter, outer, inner_loops, args.sizes, "moderate", True, args.repeats
+        )
+        print(f"  Batch wall time: {sweep_wall:.3f} s")
+    elif args.progressive_sweep and hasattr(adapter, 'triangulate_levels'):
+        sweep, sweep_wall = run_levels_benchmark(
+            adapter, outer, inner_loops, args.sizes, "moderate", True, args.repeats
+        )
+        print(f"  Progressive sweep wall time: {sweep_wall:.3f} s")
     for size in args.sizes:
         print(f"  Size: {size}")
-        points, triangles, lines, t = run_benchmark(
-            adapter, outer, inner_loops, size, "moderate", True, args.repeats
-        )
-        write_vtu(str(outdir / f'D_city_{size}.vtu'), points, triangles, lines)
-        quality = compute_mesh_quality(points, triangles)
+        if sweep is not None:
+            points, triangles, lines, t = sweep[size]
+            info = {}
+        else:
+            points, triangles, lines, t, info = run_benchmark(
+                adapter, outer, inner_loops, size, "moderate", True, args.repeats,
+                warmup=args.warmup, min_duration=args.min_duration, options=city_request(size),
+                vtu_path=str(outdir / f'D_city_{size}.vtu') if native_vtu else None
+            )
+        if not info.get('vtu_written'):
+            write_vtu(str(outdir / f'D_city_{size}.vtu'), points, triangles, lines)
+        quality = info.get('quality') or compute_mesh_quality(points, triangles)
         quality['test'] = 'D'
         quality['description'] = f'city_maxh_{size}'
         quality['maxh'] = size
@@ -303,21 +600,70 @@ def main():
             'maxh': size,
             'num_triangles': len(triangles),
             'time_sec': t,
-            'triangles_per_sec': len(triangles) / t if t > 0 else 0
+            'triangles_per_sec': len(triangles) / t if t > 0 else 0,
+            **info_columns(info),
+            **({'sweep_wall_sec': sweep_wall} if sweep_wall is not None else {})
         })
 
+    # Test E: Scale-up, N x N tilings of the city block at a fixed maxh
+    scaling = []
+    if args.scale_grids:
+        print(f"Test E: Scale-up (maxh={args.scale_maxh})")
+    for n in args.scale_grids:
+        grid_outer, grid_loops = city_grid(outer, inner_loops, n)
+        input_vertices = len(grid_outer) + sum(len(loop) for loop in grid_loops)
+        print(f"  Grid: {n}x{n} ({input_vertices} input vertices)")
+        points, triangles, lines, t, info = run_benchmark(
+            adapter, grid_outer, grid_loops, args.scale_maxh, "moderate", True, args.repeats,
+            warmup=args.warmup, min_duration=args.min_duration, options=city_request(args.scale_maxh)
+        )
+        row = {
+            'test': 'E',
+            'description': f'city_grid_{n}x{n}',
+            'maxh': args.scale_maxh,
+            'grid': n,
+            'input_vertices': input_vertices,
+            'num_triangles': len(triangles),
+            'time_sec': t,
+            'triangles_per_sec': len(triangles) / t if t > 0 else 0,
+            **info_columns(info)
+        }
+        results.append(row)
+        scaling.append(row)
+        del points, triangles, lines
+    for row, exponent in zip(scaling, scaling_exponents(scaling)):
+        row['scaling_exponent'] = exponent
+
+    for r in results:
+        median = r.get('time_median_sec')
+        r['overhead_sec'] = overhead
+        r['net_median_sec'] = max(median - overhead, 0.0) if median is not None and overhead is not None else None
+
     # Write results
     with open(outdir / f'bench_{args.software}.json', 'w') as f:
         json.dump(results, f, indent=2)
 
+    if scaling:
+        scaling_keys = ['grid', 'input_vertices', 'num_triangles', 'time_sec', 'triangles_per_sec',
+                        'peak_rss_bytes', 'scaling_exponent', *STAT_COLUMNS, *PHASE_COLUMNS]
+        with open(outdir / f'scaling_{args.software}.json', 'w') as f:
+            json.dump({
+                'maxh': args.scale_maxh,
+                'rows': [{key: row.get(key) for key in scaling_keys} for row in scaling],
+            }, f, indent=2)
+
     # Write CSV
     csv_path = outdir / f'bench_{args.software}.csv'
     with open(csv_path, 'w') as f:
-        f.write('test,description,maxh,num_triangles,time_sec,triangles_per_sec\n')
+        extra_columns = STAT_COLUMNS + PHASE_COLUMNS + SCALE_COLUMNS
+        f.write('test,description,maxh,num_triangles,time_sec,triangles_per_sec,'
+                + ','.join(extra_columns) + '\n')
         for r in results:
             maxh = r.get('maxh', '')
+            phases = ','.join('' if r.get(c) is None else f"{r[c]:.6f}" if isinstance(r[c], float) else str(r[c])
+                              for c in extra_columns)
             f.write(f"{r['test']},{r['description']},{maxh},{r['num_triangles']},"
-                   f"{r['time_sec']:.6f},{r['triangles_per_sec']:.2f}\n")
+                   f"{r['time_sec']:.6f},{r['triangles_per_sec']:.2f},{phases}\n")
 
     # Write quality metrics to log file
     metrics_path = outdir / f'metrics_{args.software}.log'
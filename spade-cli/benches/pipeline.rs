@@ -0,0 +1,169 @@
+//! Per-stage benchmarks of the meshing pipeline on the city testcase
+//! (`../testcase.txt`, as harness Test D) for every maxh of the harness sweep.
+//!
+//! Each stage runs on the output of the previous ones, prepared outside the
+//! timed section: building the PSLG, bulk loading, incremental vertex insertion,
+//! constraint insertion, refinement (also in the unit frame), hole
+//! classification, extraction and both reply encodings (JSON also through the
+//! derived serializer, as a baseline).
+
+use criterion::{criterion_group, criterion_main, BatchSize, BenchmarkId, Criterion};
+use spade_cli::frame::{self, Normalize};
+use spade_cli::order::InsertionOrder;
+use spade_cli::{
+    binary, build_pslg, bulk_load, domain_area, estimate_vertices, insert_constraints, insert_vertices, json,
+    outer_faces, pool, testcase, Input, Mesher,
+};
+use std::hint::black_box;
+use std::io;
+
+/// The harness' default `--sizes`
+const SIZES: [f64; 7] = [100.0, 50.0, 20.0, 10.0, 5.0, 2.0, 1.0];
+
+fn city(maxh: f64) -> Input {
+    let path = concat!(env!("CARGO_MANIFEST_DIR"), "/../testcase.txt");
+    let (outer, inner_loops) = testcase::read(path, 1).expect("read testcase.txt");
+    Input {
+        outer,
+        inner_loops,
+        maxh: Some(maxh),
+        quality: "moderate".to_string(),
+        enforce_constraints: true,
+        ..Default::default()
+    }
+}
+
+fn stages(c: &mut Criterion) {
+    let cases: Vec<Input> = SIZES.iter().map(|&maxh| city(maxh)).collect();
+    let id = |input: &Input| BenchmarkId::from_parameter(input.maxh.unwrap());
+
+    let mut group = c.benchmark_group("build_pslg");
+    for input in &cases {
+        group.bench_with_input(id(input), input, |b, input| b.iter(|| build_pslg(black_box(input))));
+    }
+    group.finish();
+
+    let mut group = c.benchmark_group("insert_bulk");
+    for input in &cases {
+        let (vertices, edges) = build_pslg(input);
+        group.bench_with_input(id(input), input, |b, _| b.iter(|| bulk_load(&vertices, &edges).unwrap()));
+    }
+    group.finish();
+
+    // The incremental path reserves for the refined mesh, so it depends on maxh
+    for order in [InsertionOrder::Input, InsertionOrder::Hilbert, InsertionOrder::Brio] {
+        let mut group = c.benchmark_group(format!("insert_incremental_{:?}", order).to_lowercase());
+        for input in &cases {
+            let (vertices, _) = build_pslg(input);
+            let expected = estimate_vertices(vertices.len(), domain_area(input), input.maxh);
+            group.bench_with_input(id(input), input, |b, _| {
+                b.iter_batched(|| vertices.clone(), |v| insert_vertices(v, expected, order).unwrap(), BatchSize::LargeInput)
+            });
+        }
+        group.finish();
+    }
+
+    let mut group = c.benchmark_group("constrain");
+    for input in &cases {
+        let (vertices, edges) = build_pslg(input);
+        let expected = estimate_vertices(vertices.len(), domain_area(input), input.maxh);
+        let (cdt, handles) = insert_vertices(vertices, expected, InsertionOrder::Input).unwrap();
+        group.bench_with_input(id(input), input, |b, _| {
+            b.iter_batched(
+                || cdt.clone(),
+                |mut cdt| {
+                    insert_constraints(&mut cdt, &handles, &edges);
+                    cdt
+                },
+                BatchSize::LargeInput,
+            )
+        });
+    }
+    group.finish();
+
+    // The fine levels take seconds per run
+    let mut group = c.benchmark_group("refine");
+    group.sample_size(10);
+    for input in &cases {
+        group.bench_with_input(id(input), input, |b, input| {
+            b.iter_batched(
+                || Mesher::build(input).unwrap(),
+                |mut mesher| {
+                    mesher.refine(input, input.maxh);
+                    mesher
+                },
+                BatchSize::PerIteration,
+            )
+        });
+    }
+    group.finish();
+
+    // The same in the unit frame, for the effect of coordinate magnitude on the predicates
+    let mut group = c.benchmark_group("refine_unit_frame");
+    group.sample_size(10);
+    for input in &cases {
+        let mut framed = input.clone();
+        framed.normalize = Some(Normalize::Unit);
+        let (local, _) = frame::apply(&framed).unwrap();
+        group.bench_with_input(id(input), &local, |b, local| {
+            b.iter_batched(
+                || Mesher::build(local).unwrap(),
+                |mut mesher| {
+                    mesher.refine(local, local.maxh);
+                    mesher
+                },
+                BatchSize::PerIteration,
+            )
+        });
+    }
+    group.finish();
+
+    // The remaining stages work on the refined mesh
+    let refined: Vec<(Mesher, _)> = cases
+        .iter()
+        .map(|input| {
+            let mut mesher = Mesher::build(input).unwrap();
+            let excluded = mesher.refine(input, input.maxh);
+            (mesher, excluded)
+        })
+        .collect();
+
+    let mut group = c.benchmark_group("classify");
+    for (input, (mesher, _)) in cases.iter().zip(&refined) {
+        group.bench_with_input(id(input), input, |b, _| b.iter(|| outer_faces(&mesher.cdt)));
+    }
+    group.finish();
+
+    let mut group = c.benchmark_group("extract");
+    let mut outputs = Vec::with_capacity(cases.len());
+    for (input, (mut mesher, excluded)) in cases.iter().zip(refined) {
+        group.bench_with_input(id(input), input, |b, _| b.iter(|| mesher.extract(&excluded)));
+        outputs.push(mesher.extract(&excluded));
+    }
+    group.finish();
+
+    // The reply path, on all cores, and the derived serializer it replaced as the baseline
+    let threads = pool::default_threads();
+    let mut group = c.benchmark_group("serialize_json");
+    for (input, output) in cases.iter().zip(&outputs) {
+        group.bench_with_input(id(input), input, |b, _| {
+            b.iter(|| json::write_output(&mut io::sink(), output, threads).unwrap())
+        });
+    }
+    group.finish();
+
+    let mut group = c.benchmark_group("serialize_json_derive");
+    for (input, output) in cases.iter().zip(&outputs) {
+        group.bench_with_input(id(input), input, |b, _| b.iter(|| serde_json::to_writer(io::sink(), output).unwrap()));
+    }
+    group.finish();
+
+    let mut group = c.benchmark_group("serialize_binary");
+    for (input, output) in cases.iter().zip(&outputs) {
+        group.bench_with_input(id(input), input, |b, _| b.iter(|| binary::write_output(&mut io::sink(), output).unwrap()));
+    }
+    group.finish();
+}
+
+criterion_group!(benches, stages);
+criterion_main!(benches);
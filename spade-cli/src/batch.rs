@@ -0,0 +1,107 @@
+//! Batch mode (`--batch`): many parameter sets and/or geometries in one
+//! invocation, meshed in parallel.
+//!
+//! Request:
+//! ```json
+//! {"outer": [...], "inner_loops": [...],          // shared geometry, or
+//!  "geometries": [{"outer": [...], "inner_loops": [...]}, ...],
+//!  "threads": 8,                                 // optional, default: all cores
+//!  "jobs": [{"id": "maxh_50", "geometry": 0, "maxh": 50.0,
+//!            "quality": "moderate", "enforce_constraints": true}, ...]}
+//! ```
+//! A job that carries its own `outer` uses that instead of a shared geometry.
+//! Jobs already run in parallel, so each one runs on a single thread unless it
+//! sets `"threads"` itself.
+//!
+//! One JSON line is written per job as soon as it finishes (completion order):
+//! `{"id": ..., "elapsed_sec": ..., "result": {...}}` or `{"id": ..., "elapsed_sec": ..., "error": "..."}`.
+
+use crate::{json, pool, try_triangulate, Input, Output};
+use serde::{Deserialize, Serialize};
+use std::io::{self, Write};
+use std::time::Instant;
+
+#[derive(Clone, Default, Deserialize)]
+pub struct Geometry {
+    #[serde(default)]
+    pub outer: Vec<[f64; 2]>,
+    #[serde(default)]
+    pub inner_loops: Vec<Vec<[f64; 2]>>,
+}
+
+#[derive(Deserialize)]
+pub struct Job {
+    #[serde(default)]
+    pub id: serde_json::Value,
+    #[serde(default)]
+    pub geometry: usize,
+    #[serde(flatten)]
+    pub params: Input,
+}
+
+#[derive(Deserialize)]
+pub struct BatchInput {
+    #[serde(flatten)]
+    pub geometry: Geometry,
+    #[serde(default)]
+    pub geometries: Vec<Geometry>,
+    pub jobs: Vec<Job>,
+    pub threads: Option<usize>,
+}
+
+#[derive(Serialize)]
+struct JobError<'a> {
+    id: &'a serde_json::Value,
+    elapsed_sec: f64,
+    error: String,
+}
+
+fn run_job(job: &Job, geometries: &[Geometry]) -> (f64, Result<Output, String>) {
+    let start = Instant::now();
+    let result = if !job.params.outer.is_empty() {
+        try_triangulate(&job.params)
+    } else if let Some(geometry) = geometries.get(job.geometry) {
+        let input = Input {
+            outer: geometry.outer.clone(),
+            inner_loops: geometry.inner_loops.clone(),
+            ..job.params.clone()
+        };
+        try_triangulate(&input)
+    } else {
+        Err(format!("job refers to missing geometry {}", job.geometry))
+    };
+    (start.elapsed().as_secs_f64(), result)
+}
+
+/// Mesh every job of `batch` and stream one reply line per job to `out`.
+pub fn run_batch<W: Write>(mut batch: BatchInput, out: &mut W) -> io::Result<()> {
+    let geometries = if batch.geometries.is_empty() { vec![batch.geometry] } else { batch.geometries };
+    let threads = batch.threads.unwrap_or_else(pool::default_threads);
+    for job in &mut batch.jobs {
+        job.params.threads.get_or_insert(1);
+    }
+    let jobs = &batch.jobs;
+
+    let mut status = Ok(());
+    pool::for_each_parallel(
+        jobs.len(),
+        threads,
+        |i| run_job(&jobs[i], &geometries),
+        |i, (elapsed_sec, result)| {
+            if status.is_err() {
+                return;
+            }
+            let id = &jobs[i].id;
+            status = match result {
+                // The mesh goes through the JSON encoder so that its layout options apply
+                Ok(output) => write!(out, "{{\"id\":{},\"elapsed_sec\":{},\"result\":", id, serde_json::json!(elapsed_sec))
+                    .and_then(|()| json::write_output(&mut *out, &output, 1))
+                    .and_then(|()| write!(out, "}}")),
+                Err(error) => serde_json::to_writer(&mut *out, &JobError { id, elapsed_sec, error }).map_err(io::Error::from),
+            }
+            .and_then(|()| writeln!(out))
+            .and_then(|()| out.flush());
+        },
+    );
+    status
+}
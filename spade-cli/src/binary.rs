@@ -0,0 +1,221 @@
+//! Binary wire format, selected with `--format binary`.
+//!
+//! All values are little-endian. Frames are self-delimiting, so the same
+//! encoding works for a single request and for `--serve`.
+//!
+//! Request:
+//! ```text
+//! magic        b"SPRQ"
+//! params_len   u32      length of the JSON parameter blob
+//! num_loops    u32      outer loop + inner loops
+//! num_points   u32      total vertex count over all loops
+//! params       [u8; params_len]            JSON `Input` without `outer`/`inner_loops`
+//! offsets      [u32; num_loops + 1]        loop i spans points offsets[i]..offsets[i+1]
+//! coords       [f64; 2 * num_points]       x0 y0 x1 y1 ...
+//! ```
+//!
+//! Response (24-byte header, so every array stays aligned for `numpy.frombuffer`):
+//! ```text
+//! magic          b"SPRS"
+//! status         u16    0 = ok, 1 = error
+//! layout         u16    LAYOUT_* bits, 0 for the default layout
+//! num_points     u32
+//! num_triangles  u32
+//! num_edges      u32
+//! extra_len      u32    length of the trailing UTF-8 blob
+//! points         [f64; 3 * num_points]      f32 with LAYOUT_F32, 2 per point with LAYOUT_2D
+//! padding        zero bytes up to a multiple of the index size
+//! triangles      [u32; 3 * num_triangles]   u64 with LAYOUT_U64
+//! edges          [u32; 2 * num_edges]       u64 with LAYOUT_U64
+//! extra          [u8; extra_len]
+//! ```
+//! The layout follows the request's `coord_type`, `dims` and `index_type` (see
+//! `layout.rs`). On failure `extra` is the error message. On success it is either
+//! empty or a JSON object with the reply fields besides the mesh arrays
+//! (`timings`, `quality`).
+
+use crate::layout::{CoordType, IndexType, Layout};
+use crate::{Input, Output};
+use std::io::{self, Read, Write};
+
+pub const REQUEST_MAGIC: &[u8; 4] = b"SPRQ";
+pub const RESPONSE_MAGIC: &[u8; 4] = b"SPRS";
+
+const STATUS_OK: u16 = 0;
+const STATUS_ERROR: u16 = 1;
+
+pub const LAYOUT_F32: u16 = 1;
+pub const LAYOUT_2D: u16 = 2;
+pub const LAYOUT_U64: u16 = 4;
+
+fn layout_bits(layout: Layout) -> u16 {
+    let mut bits = 0;
+    if layout.coord == CoordType::F32 {
+        bits |= LAYOUT_F32;
+    }
+    if layout.dims.get() == 2 {
+        bits |= LAYOUT_2D;
+    }
+    if layout.index == IndexType::U64 {
+        bits |= LAYOUT_U64;
+    }
+    bits
+}
+
+/// A request as read from the wire, before the parameters are interpreted.
+pub struct Frame {
+    params: Vec<u8>,
+    offsets: Vec<u32>,
+    coords: Vec<f64>,
+}
+
+fn read_u32<R: Read>(r: &mut R) -> io::Result<u32> {
+    let mut buf = [0u8; 4];
+    r.read_exact(&mut buf)?;
+    Ok(u32::from_le_bytes(buf))
+}
+
+fn invalid(msg: impl Into<String>) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg.into())
+}
+
+/// Read one request frame. Returns `Ok(None)` on a clean end of stream.
+pub fn read_frame<R: Read>(r: &mut R) -> io::Result<Option<Frame>> {
+    let mut magic = [0u8; 4];
+    match r.read_exact(&mut magic) {
+        Ok(()) => {}
+        Err(e) if e.kind() == io::ErrorKind::UnexpectedEof => return Ok(None),
+        Err(e) => return Err(e),
+    }
+    if &magic != REQUEST_MAGIC {
+        return Err(invalid("bad request magic"));
+    }
+
+    let params_len = read_u32(r)? as usize;
+    let num_loops = read_u32(r)? as usize;
+    let num_points = read_u32(r)? as usize;
+
+    let mut params = vec![0u8; params_len];
+    r.read_exact(&mut params)?;
+
+    let mut buf = vec![0u8; (num_loops + 1) * 4];
+    r.read_exact(&mut buf)?;
+    let offsets = buf
+        .chunks_exact(4)
+        .map(|b| u32::from_le_bytes(b.try_into().unwrap()))
+        .collect();
+
+    let mut buf = vec![0u8; num_points * 16];
+    r.read_exact(&mut buf)?;
+    let coords = buf
+        .chunks_exact(8)
+        .map(|b| f64::from_le_bytes(b.try_into().unwrap()))
+        .collect();
+
+    Ok(Some(Frame { params, offsets, coords }))
+}
+
+/// Interpret a frame: parse the parameter blob and split the coordinates into loops.
+pub fn decode(frame: Frame) -> Result<Input, String> {
+    let mut input: Input = serde_json::from_slice(&frame.params).map_err(|e| e.to_string())?;
+
+    let num_points = frame.coords.len() / 2;
+    let mut loops = Vec::with_capacity(frame.offsets.len().saturating_sub(1));
+    for w in frame.offsets.windows(2) {
+        let (start, end) = (w[0] as usize, w[1] as usize);
+        if start > end || end > num_points {
+            return Err(format!("invalid loop offsets {}..{}", start, end));
+        }
+        loops.push((start..end).map(|i| [frame.coords[2 * i], frame.coords[2 * i + 1]]).collect());
+    }
+
+    let mut loops = loops.into_iter();
+    input.outer = loops.next().unwrap_or_default();
+    input.inner_loops = loops.collect();
+    Ok(input)
+}
+
+fn write_header<W: Write>(w: &mut W, status: u16, layout: u16, counts: [usize; 3], extra_len: usize) -> io::Result<()> {
+    w.write_all(RESPONSE_MAGIC)?;
+    w.write_all(&status.to_le_bytes())?;
+    w.write_all(&layout.to_le_bytes())?;
+    for count in counts {
+        let count = u32::try_from(count).map_err(|_| invalid("mesh too large for u32 indices"))?;
+        w.write_all(&count.to_le_bytes())?;
+    }
+    w.write_all(&(extra_len as u32).to_le_bytes())
+}
+
+/// Encoded values are collected in a buffer of about this size before each write,
+/// so a reply is streamed out without ever being materialized in full.
+pub const CHUNK_BYTES: usize = 64 * 1024;
+
+fn write_chunked<W: Write, T>(w: &mut W, items: &[T], encode: impl Fn(&T, &mut Vec<u8>)) -> io::Result<()> {
+    let mut buf = Vec::with_capacity(CHUNK_BYTES + 64);
+    for item in items {
+        encode(item, &mut buf);
+        if buf.len() >= CHUNK_BYTES {
+            w.write_all(&buf)?;
+            buf.clear();
+        }
+    }
+    w.write_all(&buf)
+}
+
+fn write_indices<W: Write, const N: usize>(w: &mut W, items: &[[usize; N]], index: IndexType) -> io::Result<()> {
+    match index {
+        IndexType::U32 => write_chunked(w, items, |item, buf| {
+            for &i in item {
+                buf.extend_from_slice(&(i as u32).to_le_bytes());
+            }
+        }),
+        IndexType::U64 => write_chunked(w, items, |item, buf| {
+            for &i in item {
+                buf.extend_from_slice(&(i as u64).to_le_bytes());
+            }
+        }),
+    }
+}
+
+pub fn write_output<W: Write>(w: &mut W, output: &Output) -> io::Result<()> {
+    let extra = output.info_json().unwrap_or_default();
+    let layout = output.layout;
+    let dims = layout.dims.get();
+
+    let counts = [output.points.len(), output.triangles.len(), output.constraint_edges.len()];
+    write_header(w, STATUS_OK, layout_bits(layout), counts, extra.len())?;
+
+    let coord_size = match layout.coord {
+        CoordType::F32 => {
+            write_chunked(w, &output.points, |p, buf| {
+                for c in &p[..dims] {
+                    buf.extend_from_slice(&(*c as f32).to_le_bytes());
+                }
+            })?;
+            4
+        }
+        CoordType::F64 => {
+            write_chunked(w, &output.points, |p, buf| {
+                for c in &p[..dims] {
+                    buf.extend_from_slice(&c.to_le_bytes());
+                }
+            })?;
+            8
+        }
+    };
+    // Only an odd number of 3D f32 points leaves u64 indices unaligned
+    let index_size = if layout.index == IndexType::U64 { 8 } else { 4 };
+    let padding = (coord_size * dims * output.points.len()) % index_size;
+    if padding != 0 {
+        w.write_all(&[0; 8][..index_size - padding])?;
+    }
+
+    write_indices(w, &output.triangles, layout.index)?;
+    write_indices(w, &output.constraint_edges, layout.index)?;
+    w.write_all(extra.as_bytes())
+}
+
+pub fn write_error<W: Write>(w: &mut W, message: &str) -> io::Result<()> {
+    write_header(w, STATUS_ERROR, 0, [0; 3], message.len())?;
+    w.write_all(message.as_bytes())
+}
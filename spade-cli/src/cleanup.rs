@@ -0,0 +1,159 @@
+//! Optional input cleanup before insertion.
+//!
+//! `"clean_tolerance": t` snaps vertices closer than `t` to each other (across
+//! all loops) and then drops, per loop, repeated vertices and vertices within `t`
+//! of the segment joining their neighbours (collinear runs, tiny steps and
+//! spikes). `"simplify_tolerance": s` additionally simplifies each loop with
+//! Douglas–Peucker. Loops left with fewer than three vertices are dropped.
+//!
+//! Both stages can make a valid input self-intersecting if the tolerances exceed
+//! the smallest feature distance; spade then rejects the constraints.
+
+use crate::Input;
+use serde::Serialize;
+use std::collections::HashMap;
+
+type P = [f64; 2];
+
+/// What the cleanup removed.
+#[derive(Clone, Copy, Default, Serialize)]
+pub struct Report {
+    pub vertices_removed: usize,
+    pub loops_removed: usize,
+}
+
+fn dist2(a: P, b: P) -> f64 {
+    (a[0] - b[0]).powi(2) + (a[1] - b[1]).powi(2)
+}
+
+/// Squared distance from `p` to the segment `a`-`b`.
+pub(crate) fn segment_dist2(p: P, a: P, b: P) -> f64 {
+    let d = [b[0] - a[0], b[1] - a[1]];
+    let len2 = d[0] * d[0] + d[1] * d[1];
+    if len2 == 0.0 {
+        return dist2(p, a);
+    }
+    let t = (((p[0] - a[0]) * d[0] + (p[1] - a[1]) * d[1]) / len2).clamp(0.0, 1.0);
+    dist2(p, [a[0] + t * d[0], a[1] + t * d[1]])
+}
+
+/// Snaps points to the first earlier point within `tol`, using a grid of `tol` cells.
+struct Snapper {
+    tol: f64,
+    cells: HashMap<(i64, i64), Vec<P>>,
+}
+
+impl Snapper {
+    fn cell(&self, p: P) -> (i64, i64) {
+        ((p[0] / self.tol).floor() as i64, (p[1] / self.tol).floor() as i64)
+    }
+
+    fn snap(&mut self, p: P) -> P {
+        if !(self.tol > 0.0) {
+            return p;
+        }
+        let (cx, cy) = self.cell(p);
+        for dx in -1..=1 {
+            for dy in -1..=1 {
+                if let Some(reps) = self.cells.get(&(cx + dx, cy + dy)) {
+                    if let Some(&rep) = reps.iter().find(|&&r| dist2(p, r) <= self.tol * self.tol) {
+                        return rep;
+                    }
+                }
+            }
+        }
+        self.cells.entry((cx, cy)).or_default().push(p);
+        p
+    }
+}
+
+/// Drop repeated vertices and vertices within `tol` of their neighbours' segment.
+fn drop_negligible(points: Vec<P>, tol: f64) -> Vec<P> {
+    let tol2 = tol * tol;
+    let negligible = |a: P, b: P, c: P| segment_dist2(b, a, c) <= tol2;
+
+    let mut out: Vec<P> = Vec::with_capacity(points.len());
+    for p in points {
+        if out.last() == Some(&p) {
+            continue;
+        }
+        while out.len() >= 2 && negligible(out[out.len() - 2], out[out.len() - 1], p) {
+            out.pop();
+        }
+        out.push(p);
+    }
+
+    // The loop closes from the last vertex back to the first
+    while out.len() >= 3 {
+        let n = out.len();
+        if out[n - 1] == out[0] || negligible(out[n - 2], out[n - 1], out[0]) {
+            out.pop();
+        } else if negligible(out[n - 1], out[0], out[1]) {
+            out.remove(0);
+        } else {
+            break;
+        }
+    }
+    out
+}
+
+/// Douglas–Peucker on a closed loop, anchored at the first vertex and the vertex
+/// farthest from it.
+fn simplify(points: &[P], tol: f64) -> Vec<P> {
+    let n = points.len();
+    if n < 4 {
+        return points.to_vec();
+    }
+    let far = (1..n).max_by(|&i, &j| dist2(points[0], points[i]).total_cmp(&dist2(points[0], points[j]))).unwrap();
+
+    let mut keep = vec![false; n];
+    keep[0] = true;
+    keep[far] = true;
+    // Index ranges along the loop, `end` may be `n` for the closing vertex 0
+    let mut stack = vec![(0, far), (far, n)];
+    while let Some((start, end)) = stack.pop() {
+        let (a, b) = (points[start], points[end % n]);
+        let farthest = (start + 1..end)
+            .map(|i| (i, segment_dist2(points[i], a, b)))
+            .max_by(|x, y| x.1.total_cmp(&y.1));
+        if let Some((i, d2)) = farthest {
+            if d2 > tol * tol {
+                keep[i] = true;
+                stack.push((start, i));
+                stack.push((i, end));
+            }
+        }
+    }
+    points.iter().zip(keep).filter(|(_, k)| *k).map(|(p, _)| *p).collect()
+}
+
+/// Return a cleaned copy of `input` and what was removed, or `None` if the
+/// request does not ask for cleanup.
+pub fn apply(input: &Input) -> Option<(Input, Report)> {
+    if input.clean_tolerance.is_none() && input.simplify_tolerance.is_none() {
+        return None;
+    }
+    let tol = input.clean_tolerance.unwrap_or(0.0).max(0.0);
+    let mut snapper = Snapper { tol, cells: HashMap::new() };
+    let mut report = Report::default();
+
+    let mut clean = |lp: &[P]| -> Vec<P> {
+        let snapped = lp.iter().map(|&p| snapper.snap(p)).collect();
+        let mut out = drop_negligible(snapped, tol);
+        if let Some(s) = input.simplify_tolerance.filter(|s| *s > 0.0) {
+            out = simplify(&out, s);
+        }
+        if out.len() < 3 {
+            out.clear();
+        }
+        report.vertices_removed += lp.len() - out.len();
+        if out.is_empty() && !lp.is_empty() {
+            report.loops_removed += 1;
+        }
+        out
+    };
+
+    let outer = clean(&input.outer);
+    let inner_loops = input.inner_loops.iter().map(|lp| clean(lp)).filter(|lp| !lp.is_empty()).collect();
+    Some((Input { outer, inner_loops, ..input.clone() }, report))
+}
@@ -0,0 +1,100 @@
+//! Local coordinate frame for meshing, `"normalize"` in the request.
+//!
+//! Projected inputs sit millions of units from the origin, so their coordinate
+//! differences keep few significant bits. spade's predicates then fall back to
+//! exact arithmetic more often on near-degenerate corners. `"center"` moves the
+//! bounding box centre to the origin before insertion. `"unit"` also scales the
+//! box into `[-2, 2]`. The mesh is mapped back before the reply, so only the
+//! timings change. `maxh`, `maxh_min` and `tile_size` are scaled along; cleanup
+//! runs before, in input coordinates.
+//!
+//! The scale is a power of two and the offset a multiple of the next power of
+//! two above the half extent. For data away from the origin, both maps are then
+//! exact, and input vertices come back bit for bit. The reply info carries the
+//! frame as `frame`. spade has no predicate counters. Compare
+//! `timings.refine_sec` and `vertices_added_by_refinement` with and without the
+//! frame instead.
+
+use crate::{Input, Output};
+use serde::{Deserialize, Serialize};
+
+#[derive(Clone, Copy, Debug, Default, PartialEq, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum Normalize {
+    /// Input coordinates
+    #[default]
+    None,
+    Center,
+    Unit,
+}
+
+/// Meshing coordinates are `(p - offset) / scale`.
+#[derive(Clone, Copy, Debug, Serialize)]
+pub struct Frame {
+    pub offset: [f64; 2],
+    pub scale: f64,
+}
+
+/// The smallest power of two not below `x`, or 1 for zero and non-finite `x`.
+fn power_of_two_above(x: f64) -> f64 {
+    if x > 0.0 && x.is_finite() {
+        2f64.powi(x.log2().ceil() as i32)
+    } else {
+        1.0
+    }
+}
+
+impl Frame {
+    pub fn to_local(&self, [x, y]: [f64; 2]) -> [f64; 2] {
+        [(x - self.offset[0]) / self.scale, (y - self.offset[1]) / self.scale]
+    }
+
+    pub fn to_world(&self, [x, y]: [f64; 2]) -> [f64; 2] {
+        [x * self.scale + self.offset[0], y * self.scale + self.offset[1]]
+    }
+
+    /// A length in meshing coordinates.
+    pub fn length(&self, length: f64) -> f64 {
+        length / self.scale
+    }
+
+    /// Map a mesh built in this frame back to input coordinates.
+    pub fn restore(&self, output: &mut Output) {
+        for p in &mut output.points {
+            let [x, y] = self.to_world([p[0], p[1]]);
+            (p[0], p[1]) = (x, y);
+        }
+        if let Some(refinement) = &mut output.refinement {
+            refinement.max_triangle_area *= self.scale * self.scale;
+        }
+        output.frame = Some(*self);
+    }
+}
+
+/// The request in the frame `input` asks for, with that frame, or `None` for input coordinates.
+pub fn apply(input: &Input) -> Option<(Input, Frame)> {
+    let normalize = input.normalize.unwrap_or_default();
+    if normalize == Normalize::None || input.outer.is_empty() {
+        return None;
+    }
+    let (mut min, mut max) = ([f64::INFINITY; 2], [f64::NEG_INFINITY; 2]);
+    for &[x, y] in input.outer.iter().chain(input.inner_loops.iter().flatten()) {
+        min = [min[0].min(x), min[1].min(y)];
+        max = [max[0].max(x), max[1].max(y)];
+    }
+    let grid = power_of_two_above(0.5 * (max[0] - min[0]).max(max[1] - min[1]));
+    let center = |lo: f64, hi: f64| (0.5 * lo + 0.5 * hi) / grid;
+    let frame = Frame {
+        offset: [center(min[0], max[0]).round() * grid, center(min[1], max[1]).round() * grid],
+        scale: if normalize == Normalize::Unit { grid } else { 1.0 },
+    };
+
+    let mut local = input.clone();
+    let to_local = |points: &[[f64; 2]]| points.iter().map(|&p| frame.to_local(p)).collect::<Vec<_>>();
+    local.outer = to_local(&input.outer);
+    local.inner_loops = input.inner_loops.iter().map(|l| to_local(l)).collect();
+    local.maxh = input.maxh.map(|h| frame.length(h));
+    local.maxh_min = input.maxh_min.map(|h| frame.length(h));
+    local.tile_size = input.tile_size.map(|s| frame.length(s));
+    Some((local, frame))
+}
@@ -0,0 +1,89 @@
+//! JSON reply encoding with the mesh arrays formatted on worker threads.
+//!
+//! Workers format chunks of each array with serde_json's shortest round-trip
+//! float formatting, and the chunks are written out in order as soon as all
+//! earlier ones are done. The array is formatted in windows of two chunks per
+//! worker, so at most one window of text is held at a time, however slow the
+//! writer is. Points are written in the reply's
+//! coordinate type and dimension (see `layout.rs`); with the default layout the
+//! text is byte for byte what serde_json writes for [`Output`].
+
+use crate::layout::CoordType;
+use crate::{pool, Output};
+use serde::Serialize;
+use std::io::{self, Write};
+
+/// Array elements per formatting chunk; shorter arrays are formatted inline
+const CHUNK_ITEMS: usize = 1 << 15;
+
+/// Write `items` as a JSON array of `as_json(item)`.
+fn write_array<T: Sync, U: Serialize, W: Write>(
+    w: &mut W,
+    items: &[T],
+    threads: usize,
+    as_json: impl Fn(&T) -> U + Sync,
+) -> io::Result<()> {
+    w.write_all(b"[")?;
+    let chunks = items.len().div_ceil(CHUNK_ITEMS);
+    let window = 2 * threads.max(1);
+    let mut pending: Vec<Option<Vec<u8>>> = Vec::new();
+
+    for first in (0..chunks).step_by(window) {
+        let count = window.min(chunks - first);
+        pending.clear();
+        pending.resize_with(count, || None);
+        let (mut next, mut status) = (0, Ok(()));
+        pool::for_each_parallel(
+            count,
+            threads,
+            |i| {
+                let c = first + i;
+                let chunk = &items[c * CHUNK_ITEMS..((c + 1) * CHUNK_ITEMS).min(items.len())];
+                // About twice the binary size
+                let mut text = Vec::with_capacity(2 * std::mem::size_of_val(chunk));
+                for (j, item) in chunk.iter().enumerate() {
+                    if c > 0 || j > 0 {
+                        text.push(b',');
+                    }
+                    serde_json::to_writer(&mut text, &as_json(item)).expect("mesh arrays serialize");
+                }
+                text
+            },
+            |i, text| {
+                pending[i] = Some(text);
+                while status.is_ok() && next < count {
+                    let Some(text) = pending[next].take() else { break };
+                    status = w.write_all(&text);
+                    next += 1;
+                }
+            },
+        );
+        status?;
+    }
+    w.write_all(b"]")
+}
+
+/// Write `output` as one JSON object, formatting the mesh arrays on up to `threads` workers.
+pub fn write_output<W: Write>(w: &mut W, output: &Output, threads: usize) -> io::Result<()> {
+    let points = &output.points;
+    w.write_all(b"{\"points\":")?;
+    match (output.layout.coord, output.layout.dims.get()) {
+        (CoordType::F64, 3) => write_array(w, points, threads, |p| *p)?,
+        (CoordType::F64, _) => write_array(w, points, threads, |p| [p[0], p[1]])?,
+        (CoordType::F32, 3) => write_array(w, points, threads, |p| p.map(|c| c as f32))?,
+        (CoordType::F32, _) => write_array(w, points, threads, |p| [p[0] as f32, p[1] as f32])?,
+    }
+    w.write_all(b",\"triangles\":")?;
+    write_array(w, &output.triangles, threads, |t| *t)?;
+    w.write_all(b",\"constraint_edges\":")?;
+    write_array(w, &output.constraint_edges, threads, |e| *e)?;
+
+    // The other fields are the info object, continued after the arrays
+    match output.info_json() {
+        Some(info) => {
+            w.write_all(b",")?;
+            w.write_all(info[1..].as_bytes())
+        }
+        None => w.write_all(b"}"),
+    }
+}
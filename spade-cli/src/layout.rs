@@ -0,0 +1,85 @@
+//! Reply layout options: `"coord_type"`, `"dims"`, `"index_type"`, and the
+//! section switches `"return_edges"` and `"triangles_only"`.
+//!
+//! The mesh is always built with `f64` coordinates; the options only change how
+//! the reply encodes it. The JSON reply writes the coordinates it is asked for
+//! (`f32` values with their own shortest round-trip text) and ignores
+//! `index_type`. The binary reply also picks its array element types from it
+//! (see `binary.rs`). Dropped sections are sent as empty arrays, so every reply
+//! keeps the same keys.
+
+use crate::{Input, Output};
+use serde::Deserialize;
+
+#[derive(Clone, Copy, Debug, Default, PartialEq, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum CoordType {
+    F32,
+    #[default]
+    F64,
+}
+
+#[derive(Clone, Copy, Debug, Default, PartialEq, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum IndexType {
+    #[default]
+    U32,
+    U64,
+}
+
+/// Point dimension of the reply: 3 (`[x, y, 0.0]`, the default) or 2 (`[x, y]`).
+#[derive(Clone, Copy, Debug, PartialEq, Deserialize)]
+#[serde(try_from = "usize")]
+pub struct Dims(usize);
+
+impl Dims {
+    pub fn get(self) -> usize {
+        self.0
+    }
+}
+
+impl Default for Dims {
+    fn default() -> Self {
+        Dims(3)
+    }
+}
+
+impl TryFrom<usize> for Dims {
+    type Error = String;
+
+    fn try_from(dims: usize) -> Result<Self, String> {
+        match dims {
+            2 | 3 => Ok(Dims(dims)),
+            _ => Err(format!("dims must be 2 or 3, got {}", dims)),
+        }
+    }
+}
+
+/// How a reply encodes the mesh arrays.
+#[derive(Clone, Copy, Debug, Default, PartialEq)]
+pub struct Layout {
+    pub coord: CoordType,
+    pub dims: Dims,
+    pub index: IndexType,
+}
+
+impl Layout {
+    pub fn of(input: &Input) -> Self {
+        Layout {
+            coord: input.coord_type.unwrap_or_default(),
+            dims: input.dims.unwrap_or_default(),
+            index: input.index_type.unwrap_or_default(),
+        }
+    }
+}
+
+/// Drop the sections `input` does not want from a finished mesh and record its layout.
+pub fn apply(input: &Input, output: &mut Output) {
+    output.layout = Layout::of(input);
+    if input.triangles_only.unwrap_or(false) {
+        output.points = Vec::new();
+        output.constraint_edges = Vec::new();
+    } else if !input.return_edges.unwrap_or(true) {
+        output.constraint_edges = Vec::new();
+    }
+}
@@ -0,0 +1,41 @@
+//! Level-of-detail mode (`--levels`): one geometry refined coarse-to-fine.
+//!
+//! The request is a normal [`Input`] plus `"levels": [100.0, 50.0, ...]` (target
+//! edge lengths). The CDT is built and constrained once and refined level by level;
+//! one JSON line is written per level as soon as it is done:
+//! `{"maxh": 50.0, "elapsed_sec": ..., "result": {...}}`. `elapsed_sec` is the time
+//! since the previous snapshot, so the first level also carries the build cost.
+
+use crate::{json, layout, pool, triangulate_levels, Input};
+use serde::Deserialize;
+use std::io::{self, Write};
+use std::time::Instant;
+
+#[derive(Deserialize)]
+pub struct LevelsInput {
+    #[serde(flatten)]
+    pub input: Input,
+    pub levels: Vec<f64>,
+}
+
+/// Mesh every level of `request` and stream one reply line per level to `out`.
+pub fn run_levels<W: Write>(request: &LevelsInput, out: &mut W) -> Result<(), Box<dyn std::error::Error>> {
+    let mut status: io::Result<()> = Ok(());
+    let mut start = Instant::now();
+    let threads = request.input.threads.unwrap_or_else(pool::default_threads);
+
+    triangulate_levels(&request.input, &request.levels, |maxh, mut result| {
+        layout::apply(&request.input, &mut result);
+        if status.is_ok() {
+            let elapsed_sec = start.elapsed().as_secs_f64();
+            // The level's mesh goes through the parallel encoder
+            status = write!(out, "{{\"maxh\":{},\"elapsed_sec\":{},\"result\":", serde_json::json!(maxh), serde_json::json!(elapsed_sec))
+                .and_then(|()| json::write_output(&mut *out, &result, threads))
+                .and_then(|()| writeln!(out, "}}"))
+                .and_then(|()| out.flush());
+        }
+        start = Instant::now();
+    })?;
+
+    Ok(status?)
+}
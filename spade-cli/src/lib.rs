@@ -0,0 +1,839 @@
+//! Constrained Delaunay triangulation pipeline shared by the `spade-cli` binary
+//! and the `spade-py` extension module.
+
+use spade::handles::{FixedFaceHandle, FixedUndirectedEdgeHandle, FixedVertexHandle, InnerTag};
+use spade::{ConstrainedDelaunayTriangulation, InsertionError, Point2, Triangulation, RefinementParameters, RefinementResult, AngleLimit};
+use serde::{Deserialize, Serialize};
+use std::ops::Range;
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+pub mod batch;
+pub mod binary;
+pub mod cleanup;
+pub mod frame;
+pub mod json;
+pub mod layout;
+pub mod levels;
+pub mod memory;
+pub mod order;
+pub mod pool;
+pub mod quality;
+pub mod renumber;
+pub mod session;
+pub mod sizing;
+pub mod testcase;
+pub mod tiling;
+pub mod vtu;
+
+/// One triangulation request.
+#[derive(Clone, Default, Deserialize)]
+pub struct Input {
+    #[serde(default)]
+    pub outer: Vec<[f64; 2]>,
+    #[serde(default)]
+    pub inner_loops: Vec<Vec<[f64; 2]>>,
+    pub maxh: Option<f64>,
+    #[serde(default)]
+    pub quality: String,
+    #[serde(default)]
+    pub enforce_constraints: bool,
+    pub min_angle: Option<f64>,  // Minimum angle in degrees
+    pub exclude_holes: Option<bool>,  // If true, exclude inner loops as holes (default: true)
+    pub bulk_load: Option<bool>,  // If true, bulk load vertices and constraints (default: true)
+    pub insertion_order: Option<order::InsertionOrder>,  // Without bulk loading: "input" (default), "hilbert" or "brio"
+    pub coord_type: Option<layout::CoordType>,  // Reply coordinates: "f64" (default) or "f32"
+    pub dims: Option<layout::Dims>,  // Reply point dimension: 3 (default, z = 0) or 2
+    pub index_type: Option<layout::IndexType>,  // Binary reply indices: "u32" (default) or "u64"
+    pub return_edges: Option<bool>,  // If false, reply without constraint_edges (default: true)
+    pub triangles_only: Option<bool>,  // If true, reply with the triangles alone
+    pub renumber: Option<renumber::Renumber>,  // Output numbering: "none" (default), "hilbert" or "rcm"
+    pub return_permutation: Option<bool>,  // If true, reply with the vertex and triangle permutations
+    pub tile_size: Option<f64>,  // If set, mesh the domain as a grid of tiles this wide
+    pub threads: Option<usize>,  // Worker threads for tiling, mesh extraction and JSON encoding (default: all cores)
+    pub vtu: Option<String>,  // If set, also write the mesh to this .vtu file
+    pub vtu_compress: Option<bool>,  // If true, zlib-compress the .vtu arrays (default: false)
+    pub return_mesh: Option<bool>,  // If false, reply with an empty mesh, e.g. when only the .vtu is needed (default: true)
+    pub quality_metrics: Option<bool>,  // If true, attach mesh quality statistics to the reply (default: false)
+    pub clean_tolerance: Option<f64>,  // If set, merge near-duplicate vertices and drop collinear ones within this distance
+    pub simplify_tolerance: Option<f64>,  // If set, also simplify each loop with Douglas-Peucker at this tolerance
+    pub normalize: Option<frame::Normalize>,  // Meshing frame: "none" (default), "center" or "unit"
+    pub max_additional_vertices: Option<usize>,  // If set, stop refinement after inserting this many vertices
+    pub deadline_ms: Option<u64>,  // If set, stop refinement this long after insertion started
+    pub maxh_min: Option<f64>,  // If set with maxh, grade the target size from this at the loops up to maxh
+    pub maxh_growth: Option<f64>,  // Target size increase per unit distance from the loops (default: 0.25)
+}
+
+/// The resulting mesh.
+#[derive(Default, Serialize)]
+pub struct Output {
+    pub points: Vec<[f64; 3]>,
+    pub triangles: Vec<[usize; 3]>,
+    pub constraint_edges: Vec<[usize; 2]>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub quality: Option<quality::Quality>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub timings: Option<Timings>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub memory: Option<memory::Memory>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub cleanup: Option<cleanup::Report>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub refinement: Option<Refinement>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub vertex_permutation: Option<Vec<usize>>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub triangle_permutation: Option<Vec<usize>>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub frame: Option<frame::Frame>,
+    /// How the encoders write the arrays (see `json.rs` and `binary.rs`)
+    #[serde(skip)]
+    pub layout: layout::Layout,
+}
+
+/// Outcome of a refinement under `max_additional_vertices` or `deadline_ms`.
+#[derive(Clone, Copy, Serialize)]
+pub struct Refinement {
+    pub truncated: bool,  // Stopped by the budget; quality and size targets may not hold everywhere
+    pub worst_min_angle: f64,  // Smallest triangle angle in degrees (null without triangles)
+    pub max_triangle_area: f64,
+}
+
+impl Refinement {
+    fn of(output: &Output, truncated: bool) -> Self {
+        let (worst_min_angle, max_triangle_area) = quality::worst_triangle(&output.points, &output.triangles);
+        Refinement { truncated, worst_min_angle, max_triangle_area }
+    }
+
+    fn add(&mut self, other: &Refinement) {
+        self.truncated |= other.truncated;
+        self.worst_min_angle = self.worst_min_angle.min(other.worst_min_angle);
+        self.max_triangle_area = self.max_triangle_area.max(other.max_triangle_area);
+    }
+}
+
+/// Wall time of each pipeline phase in seconds, plus vertex counts. For tiled
+/// requests the phases are summed over tiles, i.e. they are CPU time.
+#[derive(Clone, Default, Serialize)]
+pub struct Timings {
+    pub parse_sec: f64,  // Decoding the request, set by the front end
+    pub cleanup_sec: f64,  // Input cleanup, if requested
+    pub insert_vertices_sec: f64,  // Bulk loading inserts the constraint edges here too
+    pub insert_constraints_sec: f64,
+    pub refine_sec: f64,
+    pub extract_sec: f64,
+    pub total_sec: f64,  // Everything after parsing, up to the reply
+    pub input_vertices: usize,
+    pub vertices_added_by_refinement: usize,
+}
+
+impl Timings {
+    fn add(&mut self, other: &Timings) {
+        self.parse_sec += other.parse_sec;
+        self.cleanup_sec += other.cleanup_sec;
+        self.insert_vertices_sec += other.insert_vertices_sec;
+        self.insert_constraints_sec += other.insert_constraints_sec;
+        self.refine_sec += other.refine_sec;
+        self.extract_sec += other.extract_sec;
+        self.total_sec += other.total_sec;
+        self.input_vertices += other.input_vertices;
+        self.vertices_added_by_refinement += other.vertices_added_by_refinement;
+    }
+}
+
+fn seconds_since(start: Instant) -> f64 {
+    start.elapsed().as_secs_f64()
+}
+
+/// Reply fields other than the mesh arrays, for front ends that carry them
+/// separately from the arrays (the binary `extra` blob, the Python bindings).
+#[derive(Serialize)]
+struct Info<'a> {
+    #[serde(skip_serializing_if = "Option::is_none")]
+    quality: Option<&'a quality::Quality>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    timings: Option<&'a Timings>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    memory: Option<&'a memory::Memory>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    cleanup: Option<&'a cleanup::Report>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    refinement: Option<&'a Refinement>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    vertex_permutation: Option<&'a Vec<usize>>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    triangle_permutation: Option<&'a Vec<usize>>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    frame: Option<&'a frame::Frame>,
+}
+
+impl Output {
+    /// The non-array reply fields as a JSON object, or `None` if there are none.
+    pub fn info_json(&self) -> Option<String> {
+        let info = Info {
+            quality: self.quality.as_ref(),
+            timings: self.timings.as_ref(),
+            memory: self.memory.as_ref(),
+            cleanup: self.cleanup.as_ref(),
+            refinement: self.refinement.as_ref(),
+            vertex_permutation: self.vertex_permutation.as_ref(),
+            triangle_permutation: self.triangle_permutation.as_ref(),
+            frame: self.frame.as_ref(),
+        };
+        let empty = info.quality.is_none()
+            && info.timings.is_none()
+            && info.memory.is_none()
+            && info.cleanup.is_none()
+            && info.refinement.is_none()
+            && info.vertex_permutation.is_none()
+            && info.triangle_permutation.is_none()
+            && info.frame.is_none();
+        (!empty).then(|| serde_json::to_string(&info).expect("reply info serializes"))
+    }
+}
+
+/// Set of face indices, one bit per face.
+pub struct FaceBitSet {
+    words: Vec<u64>,
+    len: usize,
+}
+
+impl FaceBitSet {
+    pub fn new(num_faces: usize) -> Self {
+        FaceBitSet { words: vec![0; num_faces.div_ceil(64)], len: 0 }
+    }
+
+    pub fn insert(&mut self, index: usize) {
+        let (word, bit) = (index / 64, 1u64 << (index % 64));
+        if self.words[word] & bit == 0 {
+            self.words[word] |= bit;
+            self.len += 1;
+        }
+    }
+
+    pub fn contains(&self, index: usize) -> bool {
+        self.words[index / 64] & (1u64 << (index % 64)) != 0
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+}
+
+/// Collapse exactly coincident vertices (such as the repeated first point that closes
+/// each loop). Returns the unique vertices in first-occurrence order together with,
+/// for every input index, the index of the unique vertex it was merged into.
+fn dedup_vertices(vertices: &[Point2<f64>]) -> (Vec<Point2<f64>>, Vec<usize>) {
+    // `+ 0.0` folds -0.0 into 0.0, which the triangulation treats as the same coordinate
+    let key = |i: usize| (vertices[i].x + 0.0, vertices[i].y + 0.0);
+
+    // Stable sort: within a run of equal points the lowest input index comes first
+    let mut order: Vec<usize> = (0..vertices.len()).collect();
+    order.sort_by(|&a, &b| {
+        let (ka, kb) = (key(a), key(b));
+        ka.0.total_cmp(&kb.0).then(ka.1.total_cmp(&kb.1))
+    });
+
+    let mut first = vec![0; vertices.len()];
+    for run in order.chunk_by(|&a, &b| key(a) == key(b)) {
+        for &i in run {
+            first[i] = run[0];
+        }
+    }
+
+    let mut unique = Vec::with_capacity(vertices.len());
+    let mut remap = vec![0; vertices.len()];
+    for i in 0..vertices.len() {
+        if first[i] == i {
+            remap[i] = unique.len();
+            unique.push(vertices[i]);
+        } else {
+            remap[i] = remap[first[i]];
+        }
+    }
+    (unique, remap)
+}
+
+/// Map edges onto deduplicated vertex indices, dropping zero-length and repeated edges.
+fn remap_edges(edges: &[[usize; 2]], remap: &[usize]) -> Vec<[usize; 2]> {
+    // The same segment may appear twice, e.g. on a wall shared by two loops
+    let mut remapped: Vec<[usize; 2]> = edges
+        .iter()
+        .map(|&[i, j]| [remap[i].min(remap[j]), remap[i].max(remap[j])])
+        .filter(|[i, j]| i != j)
+        .collect();
+    remapped.sort_unstable();
+    remapped.dedup();
+    remapped
+}
+
+/// Constrained Delaunay triangulation over plain `f64` points.
+pub type Cdt = ConstrainedDelaunayTriangulation<Point2<f64>>;
+
+/// Convert a target edge length into the refinement area limit.
+fn max_area_for(max_edge_len: f64) -> f64 {
+    // For an equilateral triangle with edge length h:
+    // area = (sqrt(3)/4) * h^2 ≈ 0.433 * h^2
+    0.433 * max_edge_len * max_edge_len
+}
+
+/// Largest vertex count [`estimate_vertices`] will ask to reserve.
+const MAX_RESERVED_VERTICES: usize = 1 << 26;
+
+fn loop_area(points: &[[f64; 2]]) -> f64 {
+    let n = points.len();
+    let twice: f64 = (0..n)
+        .map(|i| {
+            let (a, b) = (points[i], points[(i + 1) % n]);
+            a[0] * b[1] - b[0] * a[1]
+        })
+        .sum();
+    0.5 * twice.abs()
+}
+
+/// Area of the domain `input` describes (outer loop minus excluded holes).
+pub fn domain_area(input: &Input) -> f64 {
+    let mut area = loop_area(&input.outer);
+    if input.exclude_holes.unwrap_or(true) {
+        area -= input.inner_loops.iter().map(|lp| loop_area(lp)).sum::<f64>();
+    }
+    area.max(0.0)
+}
+
+/// Expected vertex count after refining `area` to target edge length `maxh`.
+/// Refined triangles average about half the area limit and a mesh has about half
+/// as many vertices as triangles, so the area over the limit approximates the
+/// vertices added.
+pub fn estimate_vertices(num_input: usize, area: f64, maxh: Option<f64>) -> usize {
+    let Some(maxh) = maxh.filter(|h| *h > 0.0) else {
+        return num_input;
+    };
+    let added = (area / max_area_for(maxh)).min(MAX_RESERVED_VERTICES as f64) as usize;
+    (num_input + added).min(MAX_RESERVED_VERTICES)
+}
+
+/// Smallest refinement round when running against a deadline
+const MIN_ROUND_VERTICES: usize = 1 << 16;
+
+/// Vertices, faces or edges per extraction chunk; smaller meshes are extracted inline
+const EXTRACT_CHUNK: usize = 1 << 16;
+
+/// Run `collect(range, out)` over chunks of `0..len` on up to `threads` workers and
+/// concatenate the results in index order.
+fn collect_chunked<T: Send>(len: usize, threads: usize, collect: impl Fn(Range<usize>, &mut Vec<T>) + Sync) -> Vec<T> {
+    let chunks = len.div_ceil(EXTRACT_CHUNK);
+    let mut parts: Vec<Vec<T>> = Vec::new();
+    parts.resize_with(chunks, Vec::new);
+    pool::for_each_parallel(
+        chunks,
+        threads,
+        |c| {
+            let range = c * EXTRACT_CHUNK..((c + 1) * EXTRACT_CHUNK).min(len);
+            let mut out = Vec::with_capacity(range.len());
+            collect(range, &mut out);
+            out
+        },
+        |c, out| parts[c] = out,
+    );
+    if parts.len() == 1 {
+        return parts.pop().unwrap();
+    }
+    let mut all = Vec::with_capacity(parts.iter().map(Vec::len).sum());
+    for part in parts {
+        all.extend(part);
+    }
+    all
+}
+
+/// Refinement parameters for `input` at target edge length `maxh`.
+fn refinement_parameters(input: &Input, maxh: Option<f64>) -> RefinementParameters<f64> {
+    let mut params = RefinementParameters::<f64>::new();
+
+    // Add maxh constraint if specified
+    if let Some(max_edge_len) = maxh {
+        params = params.with_max_allowed_area(max_area_for(max_edge_len));
+    }
+
+    params.with_angle_limit(AngleLimit::from_deg(angle_limit_deg(input)))
+}
+
+/// Minimum angle refinement enforces for `input`, in degrees.
+fn angle_limit_deg(input: &Input) -> f64 {
+    // Priority: min_angle param > quality setting > none
+    if let Some(min_angle) = input.min_angle {
+        min_angle
+    } else if input.quality == "moderate" {
+        25.0
+    } else {
+        // Default: no angle constraint
+        0.0
+    }
+}
+
+/// Faces outside the constrained loops by even-odd parity: a flood fill from the
+/// convex hull that flips between outside and inside at every constraint edge it
+/// crosses. These are the faces refinement reports with `exclude_outer_faces`,
+/// found in O(faces) without refining.
+pub fn outer_faces(cdt: &Cdt) -> FaceBitSet {
+    let mut excluded = FaceBitSet::new(cdt.num_all_faces());
+    let mut visited = FaceBitSet::new(cdt.num_all_faces());
+    let mut stack = Vec::new();
+
+    // Crossing in from the outer face: a constraint hull edge leads inside
+    for hull_edge in cdt.convex_hull() {
+        for edge in [hull_edge, hull_edge.rev()] {
+            if let Some(face) = edge.face().as_inner() {
+                if !visited.contains(face.fix().index()) {
+                    visited.insert(face.fix().index());
+                    stack.push((face, edge.is_constraint_edge()));
+                }
+            }
+        }
+    }
+
+    while let Some((face, inside)) = stack.pop() {
+        if !inside {
+            excluded.insert(face.fix().index());
+        }
+        for edge in face.adjacent_edges() {
+            if let Some(neighbor) = edge.rev().face().as_inner() {
+                if !visited.contains(neighbor.fix().index()) {
+                    visited.insert(neighbor.fix().index());
+                    stack.push((neighbor, inside != edge.is_constraint_edge()));
+                }
+            }
+        }
+    }
+    excluded
+}
+
+/// Input vertices of all loops plus the edges closing each loop.
+pub fn build_pslg(input: &Input) -> (Vec<Point2<f64>>, Vec<[usize; 2]>) {
+    // Build vertex list and edge list for CDT
+    let mut vertices = Vec::new();
+    let mut edges = Vec::new();
+    let mut vertex_idx = 0;
+
+    // Add outer loop vertices
+    let outer_start = vertex_idx;
+    for &[x, y] in &input.outer {
+        vertices.push(Point2::new(x, y));
+        vertex_idx += 1;
+    }
+    let outer_end = vertex_idx;
+
+    // Create edges for outer loop
+    for i in outer_start..outer_end {
+        let next = if i + 1 < outer_end { i + 1 } else { outer_start };
+        edges.push([i, next]);
+    }
+
+    // Add inner loops
+    for inner in &input.inner_loops {
+        let inner_start = vertex_idx;
+        for &[x, y] in inner {
+            vertices.push(Point2::new(x, y));
+            vertex_idx += 1;
+        }
+        let inner_end = vertex_idx;
+
+        // Create edges for inner loop
+        for i in inner_start..inner_end {
+            let next = if i + 1 < inner_end { i + 1 } else { inner_start };
+            edges.push([i, next]);
+        }
+    }
+
+    (vertices, edges)
+}
+
+// The pipeline stages below are public so that `benches/pipeline.rs` can time
+// them one by one.
+
+/// Bulk-load the CDT of `vertices` with `edges` as constraints. Coincident vertices
+/// are collapsed first, so that vertex handle indices stay in first-occurrence order.
+pub fn bulk_load(vertices: &[Point2<f64>], edges: &[[usize; 2]]) -> Result<Cdt, InsertionError> {
+    let (unique, remap) = dedup_vertices(vertices);
+    Cdt::bulk_load_cdt_stable(unique, remap_edges(edges, &remap))
+}
+
+/// Insert `vertices` one by one in `order`; returns the CDT and, by input index,
+/// each vertex's handle, with duplicates resolving to the already inserted handle.
+/// Handle (and so output) indices follow the insertion order. The DCEL is sized
+/// for `expected_vertices` up front (about 3 edges and 2 faces per vertex) so that
+/// refinement does not keep reallocating it.
+pub fn insert_vertices(
+    vertices: Vec<Point2<f64>>,
+    expected_vertices: usize,
+    order: order::InsertionOrder,
+) -> Result<(Cdt, Vec<FixedVertexHandle>), InsertionError> {
+    let capacity = expected_vertices.max(vertices.len());
+    let mut cdt = Cdt::with_capacity(capacity, 3 * capacity, 2 * capacity);
+    if order == order::InsertionOrder::Input {
+        let mut vertex_handles = Vec::with_capacity(vertices.len());
+        for vertex in vertices {
+            vertex_handles.push(cdt.insert(vertex)?);
+        }
+        return Ok((cdt, vertex_handles));
+    }
+
+    let mut vertex_handles = vec![FixedVertexHandle::from_index(0); vertices.len()];
+    for i in order::insertion_order(&vertices, order) {
+        vertex_handles[i] = cdt.insert(vertices[i])?;
+    }
+    Ok((cdt, vertex_handles))
+}
+
+/// Add `edges` (indices into `vertex_handles`) as constraints, skipping degenerate ones.
+pub fn insert_constraints(cdt: &mut Cdt, vertex_handles: &[FixedVertexHandle], edges: &[[usize; 2]]) {
+    for &[i, j] in edges {
+        if i != j && i < vertex_handles.len() && j < vertex_handles.len() {
+            let (vi, vj) = (vertex_handles[i], vertex_handles[j]);
+            if vi != vj {
+                cdt.add_constraint(vi, vj);
+            }
+        }
+    }
+}
+
+/// A CDT built from an [`Input`]. It can be refined several times, each time to a
+/// finer size, and extracted after every pass.
+pub struct Mesher {
+    pub cdt: Cdt,
+    has_constraints: bool,
+    exclude_holes: bool,
+    /// Forbid refinement from splitting constraint edges (used where a neighbouring
+    /// mesh must see exactly the same boundary vertices)
+    pub keep_constraint_edges: bool,
+    /// Vertices refinement may still add, and when it must stop (from the request
+    /// by default; tiled requests share one deadline between tiles)
+    pub vertex_budget: Option<usize>,
+    pub deadline: Option<Instant>,
+    /// Whether the last refinement stopped early
+    truncated: bool,
+    /// Graded target size, applied before spade's own refinement
+    pub size_field: Option<Arc<sizing::SizeField>>,
+    /// Workers for extraction (1 where tiles are already meshed in parallel)
+    pub threads: usize,
+    /// Phases run so far; moved into the next extracted [`Output`]
+    pub timings: Timings,
+    pub memory: memory::Memory,
+}
+
+impl Mesher {
+    /// Insert the input vertices and, if requested, the loop edges as constraints.
+    pub fn build(input: &Input) -> Result<Self, InsertionError> {
+        let (vertices, edges) = build_pslg(input);
+        let expected_vertices = estimate_vertices(vertices.len(), domain_area(input), input.maxh);
+        Self::from_pslg(input, vertices, edges, expected_vertices)
+    }
+
+    /// Like [`Mesher::build`], but for an explicit vertex and edge list of a domain
+    /// expected to refine to about `expected_vertices` vertices.
+    pub fn from_pslg(
+        input: &Input,
+        vertices: Vec<Point2<f64>>,
+        edges: Vec<[usize; 2]>,
+        expected_vertices: usize,
+    ) -> Result<Self, InsertionError> {
+        let has_constraints = input.enforce_constraints && !edges.is_empty();
+        let mut timings = Timings::default();
+        let mut memory = memory::Memory::default();
+        let start = Instant::now();
+        let mut phase = memory::Phase::start();
+        let cdt = if input.bulk_load.unwrap_or(true) {
+            let cdt = bulk_load(&vertices, if has_constraints { &edges } else { &[] })?;
+            timings.insert_vertices_sec = seconds_since(start);
+            memory.insert = phase.end();
+            cdt
+        } else {
+            let (mut cdt, vertex_handles) = insert_vertices(vertices, expected_vertices, input.insertion_order.unwrap_or_default())?;
+            timings.insert_vertices_sec = seconds_since(start);
+            memory.insert = phase.end();
+            phase = memory::Phase::start();
+
+            // Add constraint edges if requested
+            if has_constraints {
+                insert_constraints(&mut cdt, &vertex_handles, &edges);
+            }
+            timings.insert_constraints_sec = seconds_since(start) - timings.insert_vertices_sec;
+            memory.constrain = phase.end();
+            cdt
+        };
+        timings.input_vertices = cdt.num_vertices();
+
+        Ok(Mesher {
+            cdt,
+            has_constraints,
+            exclude_holes: input.exclude_holes.unwrap_or(true),  // Default: exclude holes
+            keep_constraint_edges: false,
+            vertex_budget: input.max_additional_vertices,
+            deadline: input.deadline_ms.map(|ms| start + Duration::from_millis(ms)),
+            truncated: false,
+            size_field: None,
+            threads: input.threads.unwrap_or_else(pool::default_threads),
+            timings,
+            memory,
+        })
+    }
+
+    /// Refine to target edge length `maxh` and return the faces excluded from the
+    /// mesh (outer region and holes).
+    pub fn refine(&mut self, input: &Input, maxh: Option<f64>) -> FaceBitSet {
+        self.truncated = false;
+
+        // Without constraint edges there is nothing to refine unless a size is requested
+        if !self.has_constraints && maxh.is_none() {
+            return FaceBitSet::new(self.cdt.num_all_faces());
+        }
+
+        let exclude = self.has_constraints && self.exclude_holes;
+
+        // With neither a size nor an angle target refinement would only classify the
+        // faces, which the flood fill does without inserting vertices
+        if maxh.is_none() && !(angle_limit_deg(input) > 0.0) {
+            if !exclude {
+                return FaceBitSet::new(self.cdt.num_all_faces());
+            }
+            let (start, phase) = (Instant::now(), memory::Phase::start());
+            let excluded = outer_faces(&self.cdt);
+            self.timings.refine_sec += seconds_since(start);
+            self.memory.refine.add(&phase.end());
+            return excluded;
+        }
+
+        // Use refinement to properly identify and exclude holes (only if we have constraint edges)
+        let mut params = refinement_parameters(input, maxh).exclude_outer_faces(exclude);
+        if self.keep_constraint_edges {
+            params = params.keep_constraint_edges();
+        }
+        let (start, phase, before) = (Instant::now(), memory::Phase::start(), self.cdt.num_vertices());
+        if let Some(field) = self.size_field.clone() {
+            self.refine_graded(&field, exclude);
+        }
+        let result = self.refine_within_budget(params);
+        self.timings.vertices_added_by_refinement += self.cdt.num_vertices() - before;
+
+        // Face handles are dense indices, so excluded faces fit in a bitset
+        let excluded = match result {
+            Some(result) if exclude => {
+                let mut excluded = FaceBitSet::new(self.cdt.num_all_faces());
+                for face in result.excluded_faces {
+                    excluded.insert(face.index());
+                }
+                excluded
+            }
+            // The budget was spent before refinement could start
+            None if exclude => outer_faces(&self.cdt),
+            _ => FaceBitSet::new(self.cdt.num_all_faces()),
+        };
+        self.timings.refine_sec += seconds_since(start);
+        self.memory.refine.add(&phase.end());
+        excluded
+    }
+
+    /// Insert the centroids of all triangles larger than `field` allows at their
+    /// centroid, pass after pass, until none is left or the budget is spent.
+    fn refine_graded(&mut self, field: &sizing::SizeField, exclude: bool) {
+        loop {
+            let expired = self.deadline.is_some_and(|deadline| Instant::now() >= deadline);
+            if self.vertex_budget == Some(0) || expired {
+                self.truncated = true;
+                return;
+            }
+
+            let excluded = if exclude { outer_faces(&self.cdt) } else { FaceBitSet::new(self.cdt.num_all_faces()) };
+            let mut centroids: Vec<Point2<f64>> = self
+                .cdt
+                .inner_faces()
+                .filter(|face| !excluded.contains(face.fix().index()))
+                .map(|face| (face.area(), face.center()))
+                .filter(|(area, c)| *area > max_area_for(field.size_at([c.x, c.y])))
+                .map(|(_, c)| c)
+                .collect();
+            if let Some(budget) = self.vertex_budget {
+                centroids.truncate(budget);
+            }
+
+            let before = self.cdt.num_vertices();
+            for c in centroids {
+                // A centroid lies inside its triangle, so it is a valid position
+                let _ = self.cdt.insert(c);
+            }
+            let added = self.cdt.num_vertices() - before;
+            if added == 0 {
+                return;
+            }
+            if let Some(budget) = &mut self.vertex_budget {
+                *budget = budget.saturating_sub(added);
+            }
+        }
+    }
+
+    /// Run `cdt.refine(params)` within the vertex budget and deadline. Against a
+    /// deadline refinement runs in rounds of at least [`MIN_ROUND_VERTICES`] or half
+    /// the mesh, with the clock checked in between, so the deadline can be overrun
+    /// by one round. Returns the last round's result, or `None` if none ran.
+    fn refine_within_budget(&mut self, params: RefinementParameters<f64>) -> Option<RefinementResult> {
+        if self.vertex_budget.is_none() && self.deadline.is_none() {
+            return Some(self.cdt.refine(params));
+        }
+
+        let mut last = None;
+        loop {
+            let expired = self.deadline.is_some_and(|deadline| Instant::now() >= deadline);
+            if self.vertex_budget == Some(0) || expired {
+                self.truncated = true;
+                return last;
+            }
+
+            let round = self.deadline.map(|_| (self.cdt.num_vertices() / 2).max(MIN_ROUND_VERTICES));
+            let limit = match (self.vertex_budget, round) {
+                (Some(budget), Some(round)) => budget.min(round),
+                (budget, round) => budget.or(round).unwrap_or(usize::MAX),
+            };
+            let before = self.cdt.num_vertices();
+            let result = self.cdt.refine(params.clone().with_max_additional_vertices(limit));
+            let added = self.cdt.num_vertices() - before;
+            if let Some(budget) = &mut self.vertex_budget {
+                *budget = budget.saturating_sub(added);
+            }
+
+            let (complete, stalled) = (result.refinement_complete, added == 0);
+            last = Some(result);
+            if complete || stalled {
+                self.truncated = !complete;
+                return last;
+            }
+        }
+    }
+
+    /// Copy the current mesh, minus `excluded` faces, into an [`Output`], along with
+    /// the timings collected since the previous extraction.
+    pub fn extract(&mut self, excluded: &FaceBitSet) -> Output {
+        let (start, phase) = (Instant::now(), memory::Phase::start());
+        let (cdt, threads) = (&self.cdt, self.threads);
+
+        // Each array is collected over handle index ranges in parallel. A vertex's
+        // output index is its handle index, and triangles and edges come out in
+        // handle order as with the serial iterators
+        let output_points = collect_chunked(cdt.num_vertices(), threads, |range, out| {
+            for i in range {
+                let pos = cdt.vertex(FixedVertexHandle::from_index(i)).position();
+                out.push([pos.x, pos.y, 0.0]);
+            }
+        });
+
+        // Face 0 is the outer face; skip excluded faces (holes and outer boundary)
+        let output_triangles = collect_chunked(cdt.num_inner_faces(), threads, |range, out| {
+            for i in range.start + 1..range.end + 1 {
+                if !excluded.contains(i) {
+                    let face = cdt.face(FixedFaceHandle::<InnerTag>::from_index(i));
+                    out.push(face.vertices().map(|v| v.fix().index()));
+                }
+            }
+        });
+
+        let constraint_edges = collect_chunked(cdt.num_undirected_edges(), threads, |range, out| {
+            for i in range {
+                let edge = cdt.undirected_edge(FixedUndirectedEdgeHandle::from_index(i));
+                if edge.is_constraint_edge() {
+                    out.push(edge.vertices().map(|v| v.fix().index()));
+                }
+            }
+        });
+
+        let mut output = Output {
+            points: output_points,
+            triangles: output_triangles,
+            constraint_edges,
+            ..Default::default()
+        };
+        if self.vertex_budget.is_some() || self.deadline.is_some() {
+            output.refinement = Some(Refinement::of(&output, self.truncated));
+        }
+
+        self.timings.extract_sec += seconds_since(start);
+        self.memory.extract.add(&phase.end());
+        output.timings = Some(std::mem::take(&mut self.timings));
+        output.memory = memory::enabled().then(|| std::mem::take(&mut self.memory));
+        output
+    }
+}
+
+/// Build the CDT for `input`, refine it and extract the mesh.
+pub fn triangulate(input: &Input) -> Result<Output, Box<dyn std::error::Error>> {
+    let start = Instant::now();
+    let cleaned = cleanup::apply(input);
+    let cleanup_sec = seconds_since(start);
+    let input = cleaned.as_ref().map_or(input, |(cleaned, _)| cleaned);
+    let framed = frame::apply(input);
+    let local = framed.as_ref().map_or(input, |(local, _)| local);
+
+    let mut output = if let Some(tile_size) = local.tile_size {
+        tiling::triangulate_tiled(local, tile_size)?
+    } else {
+        let mut mesher = Mesher::build(local)?;
+        mesher.size_field = sizing::SizeField::from_input(local)?.map(Arc::new);
+        let excluded = mesher.refine(local, local.maxh);
+        mesher.extract(&excluded)
+    };
+    if let Some((_, frame)) = &framed {
+        frame.restore(&mut output);
+    }
+    renumber::apply(input, &mut output);
+    quality::attach(input, &mut output);
+    output.cleanup = cleaned.as_ref().map(|(_, report)| *report);
+    let timings = output.timings.get_or_insert_with(Default::default);
+    timings.cleanup_sec = cleanup_sec;
+    timings.total_sec = seconds_since(start);
+    Ok(output)
+}
+
+/// Coarse-to-fine triangulation: build and constrain the CDT once, then refine it
+/// to each of `levels` (target edge lengths, processed largest first), handing a
+/// snapshot of the mesh to `on_level` after every level. The finer levels are
+/// refinements of the coarser ones rather than independent meshes.
+pub fn triangulate_levels(
+    input: &Input,
+    levels: &[f64],
+    mut on_level: impl FnMut(f64, Output),
+) -> Result<(), Box<dyn std::error::Error>> {
+    let mut levels = levels.to_vec();
+    levels.sort_by(|a, b| b.total_cmp(a));
+
+    let mut start = Instant::now();
+    let cleaned = cleanup::apply(input);
+    let mut cleanup_sec = seconds_since(start);
+    let input = cleaned.as_ref().map_or(input, |(cleaned, _)| cleaned);
+    let framed = frame::apply(input);
+    let local = framed.as_ref().map_or(input, |(local, _)| local);
+
+    let mut mesher = Mesher::build(local)?;
+    mesher.size_field = sizing::SizeField::from_input(local)?.map(Arc::new);
+    for maxh in levels {
+        let excluded = mesher.refine(local, Some(framed.as_ref().map_or(maxh, |(_, frame)| frame.length(maxh))));
+        let mut output = mesher.extract(&excluded);
+        if let Some((_, frame)) = &framed {
+            frame.restore(&mut output);
+        }
+        renumber::apply(input, &mut output);
+        quality::attach(input, &mut output);
+        output.cleanup = cleaned.as_ref().map(|(_, report)| *report);
+        let timings = output.timings.get_or_insert_with(Default::default);
+        timings.cleanup_sec = std::mem::take(&mut cleanup_sec);
+        timings.total_sec = seconds_since(start);
+        on_level(maxh, output);
+        start = Instant::now();
+    }
+    Ok(())
+}
+
+/// Like [`triangulate`], but also reports panics from inside spade (e.g. on
+/// intersecting constraint edges) as errors, for callers that must keep running.
+/// Also writes the `.vtu` file the request asks for, see [`vtu::write_requested`].
+pub fn try_triangulate(input: &Input) -> Result<Output, String> {
+    let output = std::panic::catch_unwind(|| triangulate(input).map_err(|e| e.to_string()))
+        .unwrap_or_else(|_| Err("triangulation panicked".to_string()))?;
+    vtu::write_requested(input, output)
+}
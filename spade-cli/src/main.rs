@@ -1,201 +1,280 @@
-use spade::{ConstrainedDelaunayTriangulation, Point2, Triangulation, RefinementParameters, AngleLimit};
-use serde::{Deserialize, Serialize};
-use std::io::{self, Read};
-
-#[derive(Deserialize)]
-struct Input {
-    outer: Vec<[f64; 2]>,
-    inner_loops: Vec<Vec<[f64; 2]>>,
-    maxh: Option<f64>,
-    quality: String,
-    enforce_constraints: bool,
-    min_angle: Option<f64>,  // Minimum angle in degrees
-    exclude_holes: Option<bool>,  // If true, exclude inner loops as holes (default: true)
-}
+use serde::Serialize;
+use spade_cli::{batch, binary, json, levels, memory, pool, session, testcase, triangulate, try_triangulate, vtu, Input, Output};
+use std::io::{self, BufRead, Read, Write};
+use std::time::Instant;
+
+// Base allocator: the system one unless the `mimalloc` or `jemalloc` feature
+// selects a faster allocator for the many small allocations of refinement
+#[cfg(all(feature = "mimalloc", feature = "jemalloc"))]
+compile_error!("the mimalloc and jemalloc features are mutually exclusive");
+#[cfg(feature = "mimalloc")]
+use mimalloc::MiMalloc as BaseAlloc;
+#[cfg(feature = "jemalloc")]
+use tikv_jemallocator::Jemalloc as BaseAlloc;
+#[cfg(all(feature = "alloc-stats", not(any(feature = "mimalloc", feature = "jemalloc"))))]
+use std::alloc::System as BaseAlloc;
+
+#[cfg(feature = "alloc-stats")]
+#[global_allocator]
+static ALLOCATOR: memory::CountingAlloc<BaseAlloc> = memory::CountingAlloc(BaseAlloc);
+
+#[cfg(all(not(feature = "alloc-stats"), any(feature = "mimalloc", feature = "jemalloc")))]
+#[global_allocator]
+static ALLOCATOR: BaseAlloc = BaseAlloc;
 
 #[derive(Serialize)]
-struct Output {
-    points: Vec<[f64; 3]>,
-    triangles: Vec<[usize; 3]>,
-    constraint_edges: Vec<[usize; 2]>,
+struct ErrorOutput {
+    error: String,
 }
 
-fn main() -> Result<(), Box<dyn std::error::Error>> {
-    // Read JSON input from stdin
-    let mut input_str = String::new();
-    io::stdin().read_to_string(&mut input_str)?;
-    let input: Input = serde_json::from_str(&input_str)?;
-
-    // Build vertex list and edge list for CDT
-    let mut vertices = Vec::new();
-    let mut edges = Vec::new();
-    let mut vertex_idx = 0;
-
-    // Add outer loop vertices
-    let outer_start = vertex_idx;
-    for &[x, y] in &input.outer {
-        vertices.push(Point2::new(x, y));
-        vertex_idx += 1;
-    }
-    let outer_end = vertex_idx;
-
-    // Create edges for outer loop
-    for i in outer_start..outer_end {
-        let next = if i + 1 < outer_end { i + 1 } else { outer_start };
-        edges.push([i, next]);
-    }
-
-    // Add inner loops
-    for inner in &input.inner_loops {
-        let inner_start = vertex_idx;
-        for &[x, y] in inner {
-            vertices.push(Point2::new(x, y));
-            vertex_idx += 1;
-        }
-        let inner_end = vertex_idx;
+/// Run one request, turning decode errors and panics into an error message
+/// so that a bad request does not take down a long-lived server. Also returns
+/// the request's thread count for encoding the reply.
+fn run_guarded(format: Format, decode: impl FnOnce() -> Result<Input, String>) -> Result<(Output, usize), String> {
+    let start = Instant::now();
+    let input = decode()?;
+    let parse_sec = start.elapsed().as_secs_f64();
+    let threads = input.threads.unwrap_or_else(pool::default_threads);
+    Ok((measure_serialize(with_parse_time(try_triangulate(&input)?, parse_sec), format, threads), threads))
+}
 
-        // Create edges for inner loop
-        for i in inner_start..inner_end {
-            let next = if i + 1 < inner_end { i + 1 } else { inner_start };
-            edges.push([i, next]);
-        }
+fn with_parse_time(mut output: Output, parse_sec: f64) -> Output {
+    if let Some(timings) = output.timings.as_mut() {
+        timings.parse_sec = parse_sec;
     }
+    output
+}
 
-    // Create CDT - use incremental insertion to avoid bulk_load deduplication issues
-    let mut cdt = ConstrainedDelaunayTriangulation::<Point2<f64>>::default();
-    let mut vertex_handles = Vec::new();
+/// With `alloc-stats`, fill in the serialize phase by writing the reply once into
+/// `io::sink()` first: a reply cannot carry numbers about its own writing, and the
+/// dry run allocates like the real one.
+fn measure_serialize(mut output: Output, format: Format, threads: usize) -> Output {
+    if output.memory.is_none() {
+        return output;
+    }
+    let phase = memory::Phase::start();
+    let _ = match format {
+        Format::Json => json::write_output(&mut io::sink(), &output, threads),
+        Format::Binary => binary::write_output(&mut io::sink(), &output),
+    };
+    let stats = phase.end();
+    if let Some(memory) = output.memory.as_mut() {
+        memory.serialize = stats;
+    }
+    output
+}
 
-    for vertex in vertices {
-        let handle = cdt.insert(vertex)?;
-        vertex_handles.push(handle);
+/// Serialize a reply line straight into `out`, formatting the mesh on `threads`
+/// workers; chunks are written as they are done, and at most a window of them
+/// is held in memory (see `json.rs`).
+fn write_json_reply<W: Write>(out: &mut W, result: Result<Output, String>, threads: usize) -> io::Result<()> {
+    match result {
+        Ok(output) => json::write_output(&mut *out, &output, threads)?,
+        Err(error) => serde_json::to_writer(&mut *out, &ErrorOutput { error })?,
     }
+    writeln!(out)
+}
 
-    // Add constraint edges if requested
-    let has_constraints = input.enforce_constraints && !edges.is_empty();
-    if has_constraints {
-        for [i, j] in &edges {
-            if *i != *j && *i < vertex_handles.len() && *j < vertex_handles.len() {
-                let vi = vertex_handles[*i];
-                let vj = vertex_handles[*j];
-                if vi != vj {
-                    cdt.add_constraint(vi, vj);
+fn stdout_writer() -> io::BufWriter<io::StdoutLock<'static>> {
+    io::BufWriter::with_capacity(binary::CHUNK_BYTES, io::stdout().lock())
+}
+
+/// Server mode: handle requests in a loop until stdin is closed.
+/// JSON requests and replies are one per line; binary frames are self-delimiting.
+fn serve(format: Format) -> Result<(), Box<dyn std::error::Error>> {
+    let stdin = io::stdin();
+    let mut input = stdin.lock();
+    let mut out = stdout_writer();
+
+    match format {
+        Format::Json => {
+            for line in input.lines() {
+                let line = line?;
+                if line.trim().is_empty() {
+                    continue;
+                }
+                let result = run_guarded(format, || serde_json::from_str(&line).map_err(|e| e.to_string()));
+                let threads = result.as_ref().map_or(1, |(_, threads)| *threads);
+                write_json_reply(&mut out, result.map(|(output, _)| output), threads)?;
+                out.flush()?;
+            }
+        }
+        Format::Binary => {
+            while let Some(frame) = binary::read_frame(&mut input)? {
+                match run_guarded(format, || binary::decode(frame)) {
+                    Ok((output, _)) => binary::write_output(&mut out, &output)?,
+                    Err(error) => binary::write_error(&mut out, &error)?,
                 }
+                out.flush()?;
             }
         }
     }
 
-    // Use refinement to properly identify and exclude holes (only if we have constraint edges)
-    let should_exclude_holes = input.exclude_holes.unwrap_or(true);  // Default: exclude holes
-    let excluded_faces = if has_constraints && should_exclude_holes {
-        // Set up refinement parameters
-        let mut params = RefinementParameters::<f64>::new()
-            .exclude_outer_faces(true);  // Exclude outer boundary and holes
-
-        // Add maxh constraint if specified
-        if let Some(max_edge_len) = input.maxh {
-            // Convert edge length to approximate triangle area
-            // For an equilateral triangle with edge length h:
-            // area = (sqrt(3)/4) * h^2 ≈ 0.433 * h^2
-            let max_area = 0.433 * max_edge_len * max_edge_len;
-            params = params.with_max_allowed_area(max_area);
-        }
+    Ok(())
+}
 
-        // Set angle limit - priority: min_angle param > quality setting > none
-        if let Some(min_angle) = input.min_angle {
-            params = params.with_angle_limit(AngleLimit::from_deg(min_angle));
-        } else if input.quality == "moderate" {
-            params = params.with_angle_limit(AngleLimit::from_deg(25.0));
-        } else {
-            // Default: no angle constraint
-            params = params.with_angle_limit(AngleLimit::from_deg(0.0));
-        }
+#[derive(Clone, Copy, PartialEq)]
+enum Format {
+    Json,
+    Binary,
+}
 
-        // Perform refinement and get excluded faces (holes + outer boundary)
-        let result = cdt.refine(params);
-        result.excluded_faces
-    } else if has_constraints && !should_exclude_holes {
-        // Have constraints but want to include holes - refine everything
-        let mut params = RefinementParameters::<f64>::new()
-            .exclude_outer_faces(false);  // Include everything
-
-        // Add maxh constraint if specified
-        if let Some(max_edge_len) = input.maxh {
-            let max_area = 0.433 * max_edge_len * max_edge_len;
-            params = params.with_max_allowed_area(max_area);
-        }
+struct Args {
+    serve: bool,
+    batch: bool,
+    levels: bool,
+    session: bool,
+    format: Format,
+    vtu: Option<String>,
+    vtu_compress: bool,
+    /// Read the loops from this testcase file instead of stdin
+    testcase: Option<String>,
+    /// Request parameters for `--testcase` (JSON `Input` without the loops),
+    /// overridden by the flags below
+    params: Option<String>,
+    maxh: Option<f64>,
+    quality: Option<String>,
+    min_angle: Option<f64>,
+    enforce_constraints: bool,
+}
 
-        // Set angle limit
-        if let Some(min_angle) = input.min_angle {
-            params = params.with_angle_limit(AngleLimit::from_deg(min_angle));
-        } else if input.quality == "moderate" {
-            params = params.with_angle_limit(AngleLimit::from_deg(25.0));
-        } else {
-            params = params.with_angle_limit(AngleLimit::from_deg(0.0));
+fn parse_args() -> Result<Args, String> {
+    let mut args = Args {
+        serve: false,
+        batch: false,
+        levels: false,
+        session: false,
+        format: Format::Json,
+        vtu: None,
+        vtu_compress: false,
+        testcase: None,
+        params: None,
+        maxh: None,
+        quality: None,
+        min_angle: None,
+        enforce_constraints: false,
+    };
+    let mut iter = std::env::args().skip(1);
+    let number = |name: &str, value: Option<String>| -> Result<f64, String> {
+        value.as_deref().and_then(|v| v.parse().ok()).ok_or_else(|| format!("{} expects a number", name))
+    };
+    while let Some(arg) = iter.next() {
+        match arg.as_str() {
+            "--serve" => args.serve = true,
+            "--batch" => args.batch = true,
+            "--levels" => args.levels = true,
+            "--session" => args.session = true,
+            "--format" => {
+                args.format = match iter.next().as_deref() {
+                    Some("json") => Format::Json,
+                    Some("binary") => Format::Binary,
+                    other => return Err(format!("--format expects json or binary, got {:?}", other)),
+                }
+            }
+            "--vtu" => args.vtu = Some(iter.next().ok_or("--vtu expects a path")?),
+            "--vtu-zlib" => args.vtu_compress = true,
+            "--testcase" => args.testcase = Some(iter.next().ok_or("--testcase expects a path")?),
+            "--params" => args.params = Some(iter.next().ok_or("--params expects a JSON object")?),
+            "--maxh" => args.maxh = Some(number("--maxh", iter.next())?),
+            "--quality" => args.quality = Some(iter.next().ok_or("--quality expects default or moderate")?),
+            "--min-angle" => args.min_angle = Some(number("--min-angle", iter.next())?),
+            "--enforce-constraints" => args.enforce_constraints = true,
+            other => return Err(format!("unknown argument: {}", other)),
         }
+    }
+    Ok(args)
+}
 
-        cdt.refine(params);
-        Vec::new()
-    } else {
-        // No constraint edges: simple refinement without exclusions
-        if let Some(max_edge_len) = input.maxh {
-            let max_area = 0.433 * max_edge_len * max_edge_len;
-            let mut params = RefinementParameters::<f64>::new()
-                .with_max_allowed_area(max_area)
-                .exclude_outer_faces(false);
-
-            // Set angle limit
-            if let Some(min_angle) = input.min_angle {
-                params = params.with_angle_limit(AngleLimit::from_deg(min_angle));
-            } else if input.quality == "moderate" {
-                params = params.with_angle_limit(AngleLimit::from_deg(25.0));
-            } else {
-                params = params.with_angle_limit(AngleLimit::from_deg(0.0));
-            }
+/// `--vtu`/`--vtu-zlib` on the command line override the request fields.
+fn apply_vtu_args(input: &mut Input, args: &Args) {
+    if let Some(path) = &args.vtu {
+        input.vtu = Some(path.clone());
+    }
+    if args.vtu_compress {
+        input.vtu_compress = Some(true);
+    }
+}
 
-            cdt.refine(params);
-        }
-        Vec::new()
+/// The request for `--testcase`: parameters from `--params` and the flags, loops
+/// parsed natively from the file.
+fn testcase_input(path: &str, args: &Args) -> Result<Input, Box<dyn std::error::Error>> {
+    let mut input: Input = match &args.params {
+        Some(json) => serde_json::from_str(json)?,
+        None => Input::default(),
     };
+    if args.maxh.is_some() {
+        input.maxh = args.maxh;
+    }
+    if let Some(quality) = &args.quality {
+        input.quality = quality.clone();
+    }
+    if args.min_angle.is_some() {
+        input.min_angle = args.min_angle;
+    }
+    if args.enforce_constraints {
+        input.enforce_constraints = true;
+    }
+    let threads = input.threads.unwrap_or_else(pool::default_threads);
+    (input.outer, input.inner_loops) = testcase::read(path, threads)?;
+    Ok(input)
+}
 
-    // Convert excluded faces to a HashSet for fast lookup
-    let excluded_set: std::collections::HashSet<_> = excluded_faces.into_iter().collect();
+/// Mesh a single request and write its reply to stdout.
+fn reply_once(mut input: Input, parse_sec: f64, args: &Args) -> Result<(), Box<dyn std::error::Error>> {
+    apply_vtu_args(&mut input, args);
+    let output = with_parse_time(vtu::write_requested(&input, triangulate(&input)?)?, parse_sec);
+    let threads = input.threads.unwrap_or_else(pool::default_threads);
+    let output = measure_serialize(output, args.format, threads);
 
-    // Extract points and triangles
-    let mut point_map = std::collections::HashMap::new();
-    let mut output_points = Vec::new();
+    let mut out = stdout_writer();
+    match args.format {
+        Format::Json => write_json_reply(&mut out, Ok(output), threads)?,
+        Format::Binary => binary::write_output(&mut out, &output)?,
+    }
+    out.flush()?;
+    Ok(())
+}
 
-    for (idx, vertex) in cdt.vertices().enumerate() {
-        let pos = vertex.position();
-        point_map.insert(vertex.fix(), idx);
-        output_points.push([pos.x, pos.y, 0.0]);
+fn main() -> Result<(), Box<dyn std::error::Error>> {
+    let args = parse_args()?;
+    if args.serve {
+        return serve(args.format);
+    }
+    if args.batch {
+        // Batch requests and their streamed replies are always JSON
+        let input: batch::BatchInput = serde_json::from_reader(io::BufReader::new(io::stdin().lock()))?;
+        return Ok(batch::run_batch(input, &mut stdout_writer())?);
+    }
+    if args.levels {
+        let request: levels::LevelsInput = serde_json::from_reader(io::BufReader::new(io::stdin().lock()))?;
+        return levels::run_levels(&request, &mut stdout_writer());
+    }
+    if args.session {
+        // Session requests and replies are JSON lines
+        return Ok(session::run_session(io::stdin().lock(), &mut stdout_writer())?);
     }
 
-    let mut output_triangles = Vec::new();
-    for face in cdt.inner_faces() {
-        // Skip excluded faces (holes and outer boundary)
-        if !excluded_set.contains(&face.fix()) {
-            let vertices: [_; 3] = face.vertices().map(|v| point_map[&v.fix()]);
-            output_triangles.push([vertices[0], vertices[1], vertices[2]]);
-        }
+    if let Some(path) = &args.testcase {
+        // Reading the file counts as parsing
+        let start = Instant::now();
+        let input = testcase_input(path, &args)?;
+        return reply_once(input, start.elapsed().as_secs_f64(), &args);
     }
 
-    // Extract constraint edges
-    let mut constraint_edges = Vec::new();
-    for edge in cdt.undirected_edges() {
-        if edge.is_constraint_edge() {
-            let [v0, v1] = edge.vertices().map(|v| point_map[&v.fix()]);
-            constraint_edges.push([v0, v1]);
+    match args.format {
+        Format::Json => {
+            // Read JSON input from stdin
+            let mut input_str = String::new();
+            io::stdin().read_to_string(&mut input_str)?;
+            let start = Instant::now();
+            let input: Input = serde_json::from_str(&input_str)?;
+            reply_once(input, start.elapsed().as_secs_f64(), &args)
+        }
+        Format::Binary => {
+            let frame = binary::read_frame(&mut io::stdin().lock())?.ok_or("empty input")?;
+            let start = Instant::now();
+            let input = binary::decode(frame)?;
+            reply_once(input, start.elapsed().as_secs_f64(), &args)
         }
     }
-
-    // Output JSON result
-    let output = Output {
-        points: output_points,
-        triangles: output_triangles,
-        constraint_edges,
-    };
-
-    println!("{}", serde_json::to_string(&output)?);
-
-    Ok(())
 }
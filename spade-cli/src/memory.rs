@@ -0,0 +1,125 @@
+//! Opt-in allocation accounting, enabled with `--features alloc-stats`.
+//!
+//! With the feature on, the binary installs [`CountingAlloc`] around its base
+//! allocator (the system one, or mimalloc/jemalloc) and every reply carries a `memory` object with, per pipeline phase,
+//! the bytes and number of allocations made and the high-water mark of live heap
+//! bytes. Without it the counters stay at zero and no `memory` object is sent.
+//!
+//! The counters are process-wide, so phases that run concurrently on several
+//! threads (tiled requests, batch jobs) see each other's allocations.
+
+use serde::Serialize;
+use std::alloc::{GlobalAlloc, Layout};
+use std::sync::atomic::{AtomicUsize, Ordering::Relaxed};
+
+static ALLOCATED: AtomicUsize = AtomicUsize::new(0);
+static ALLOCATIONS: AtomicUsize = AtomicUsize::new(0);
+static LIVE: AtomicUsize = AtomicUsize::new(0);
+static PEAK: AtomicUsize = AtomicUsize::new(0);
+
+/// Another allocator plus counters.
+pub struct CountingAlloc<A>(pub A);
+
+fn record_alloc(size: usize) {
+    ALLOCATED.fetch_add(size, Relaxed);
+    ALLOCATIONS.fetch_add(1, Relaxed);
+    let live = LIVE.fetch_add(size, Relaxed) + size;
+    PEAK.fetch_max(live, Relaxed);
+}
+
+unsafe impl<A: GlobalAlloc> GlobalAlloc for CountingAlloc<A> {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        let ptr = self.0.alloc(layout);
+        if !ptr.is_null() {
+            record_alloc(layout.size());
+        }
+        ptr
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        let ptr = self.0.alloc_zeroed(layout);
+        if !ptr.is_null() {
+            record_alloc(layout.size());
+        }
+        ptr
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        self.0.dealloc(ptr, layout);
+        LIVE.fetch_sub(layout.size(), Relaxed);
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        let new_ptr = self.0.realloc(ptr, layout, new_size);
+        if !new_ptr.is_null() {
+            // Counted as a fresh allocation of the new size that frees the old block
+            LIVE.fetch_sub(layout.size(), Relaxed);
+            record_alloc(new_size);
+        }
+        new_ptr
+    }
+}
+
+/// Whether this build counts allocations.
+pub fn enabled() -> bool {
+    cfg!(feature = "alloc-stats")
+}
+
+/// Allocation activity during one phase.
+#[derive(Clone, Copy, Default, Serialize)]
+pub struct PhaseStats {
+    pub allocated_bytes: usize,
+    pub allocations: usize,
+    /// High-water mark of live heap bytes while the phase ran
+    pub peak_bytes: usize,
+}
+
+impl PhaseStats {
+    pub fn add(&mut self, other: &PhaseStats) {
+        self.allocated_bytes += other.allocated_bytes;
+        self.allocations += other.allocations;
+        self.peak_bytes = self.peak_bytes.max(other.peak_bytes);
+    }
+}
+
+/// A phase being measured; see [`Phase::end`].
+pub struct Phase {
+    allocated: usize,
+    allocations: usize,
+}
+
+impl Phase {
+    pub fn start() -> Self {
+        PEAK.store(LIVE.load(Relaxed), Relaxed);
+        Phase { allocated: ALLOCATED.load(Relaxed), allocations: ALLOCATIONS.load(Relaxed) }
+    }
+
+    pub fn end(self) -> PhaseStats {
+        PhaseStats {
+            allocated_bytes: ALLOCATED.load(Relaxed) - self.allocated,
+            allocations: ALLOCATIONS.load(Relaxed) - self.allocations,
+            peak_bytes: PEAK.load(Relaxed),
+        }
+    }
+}
+
+/// Per-phase allocation statistics of one request. Bulk loading inserts the
+/// constraint edges together with the vertices, so it reports them under `insert`.
+#[derive(Clone, Default, Serialize)]
+pub struct Memory {
+    pub insert: PhaseStats,
+    pub constrain: PhaseStats,
+    pub refine: PhaseStats,
+    pub extract: PhaseStats,
+    pub serialize: PhaseStats,
+}
+
+impl Memory {
+    pub fn add(&mut self, other: &Memory) {
+        self.insert.add(&other.insert);
+        self.constrain.add(&other.constrain);
+        self.refine.add(&other.refine);
+        self.extract.add(&other.extract);
+        self.serialize.add(&other.serialize);
+    }
+}
@@ -0,0 +1,93 @@
+//! Vertex insertion order for incremental insertion, `"insertion_order"` in the
+//! request.
+//!
+//! spade locates each new vertex by walking from the previously inserted one, so
+//! inserting in file order pays for a long walk whenever the input jumps across
+//! the domain. `"hilbert"` sorts the vertices along a Hilbert curve, so that
+//! consecutive vertices are close; `"brio"` (biased randomized insertion order)
+//! puts them in random rounds of doubling size, each round sorted along the curve,
+//! which also keeps the intermediate triangulations well shaped. Bulk loading
+//! sorts on its own and ignores the setting.
+
+use serde::Deserialize;
+use spade::Point2;
+
+#[derive(Clone, Copy, Debug, Default, PartialEq, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum InsertionOrder {
+    /// Input order: outer loop first, then the inner loops as given
+    #[default]
+    Input,
+    Hilbert,
+    Brio,
+}
+
+/// Hilbert curve resolution: coordinates are quantized to a 2^16 x 2^16 grid
+const ORDER_BITS: u32 = 16;
+
+/// Position of grid cell `(x, y)` along the Hilbert curve.
+fn hilbert_index(mut x: u32, mut y: u32) -> u64 {
+    let n = 1u32 << ORDER_BITS;
+    let mut d = 0u64;
+    let mut s = n / 2;
+    while s > 0 {
+        let rx = (x & s != 0) as u32;
+        let ry = (y & s != 0) as u32;
+        d += (s as u64) * (s as u64) * ((3 * rx) ^ ry) as u64;
+        // Rotate the quadrant so the curve continues where the last one ended
+        if ry == 0 {
+            if rx == 1 {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::mem::swap(&mut x, &mut y);
+        }
+        s /= 2;
+    }
+    d
+}
+
+/// Hilbert curve position of every item, with its coordinates given by `xy`,
+/// on a grid spanning the items' bounding square.
+pub(crate) fn hilbert_keys<T>(items: &[T], xy: impl Fn(&T) -> [f64; 2]) -> Vec<u64> {
+    let (mut min, mut max) = ([f64::INFINITY; 2], [f64::NEG_INFINITY; 2]);
+    for [x, y] in items.iter().map(&xy) {
+        min = [min[0].min(x), min[1].min(y)];
+        max = [max[0].max(x), max[1].max(y)];
+    }
+    let span = (max[0] - min[0]).max(max[1] - min[1]);
+    let scale = if span > 0.0 { ((1u32 << ORDER_BITS) - 1) as f64 / span } else { 0.0 };
+    items
+        .iter()
+        .map(&xy)
+        .map(|[x, y]| hilbert_index(((x - min[0]) * scale) as u32, ((y - min[1]) * scale) as u32))
+        .collect()
+}
+
+/// Round of vertex `i` in a BRIO: round k holds about 2^-(k+1) of the vertices.
+/// A fixed hash instead of a random generator keeps meshes reproducible.
+fn brio_round(i: usize) -> u32 {
+    // SplitMix64 finalizer
+    let mut z = (i as u64).wrapping_add(0x9e37_79b9_7f4a_7c15);
+    z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+    z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+    (z ^ (z >> 31)).trailing_zeros().min(31)
+}
+
+/// Input indices of `vertices` in the order they should be inserted.
+pub fn insertion_order(vertices: &[Point2<f64>], order: InsertionOrder) -> Vec<usize> {
+    let mut indices: Vec<usize> = (0..vertices.len()).collect();
+    match order {
+        InsertionOrder::Input => {}
+        InsertionOrder::Hilbert => {
+            let keys = hilbert_keys(vertices, |v| [v.x, v.y]);
+            indices.sort_unstable_by_key(|&i| keys[i]);
+        }
+        InsertionOrder::Brio => {
+            // The smallest round goes first
+            let keys = hilbert_keys(vertices, |v| [v.x, v.y]);
+            indices.sort_unstable_by_key(|&i| (std::cmp::Reverse(brio_round(i)), keys[i]));
+        }
+    }
+    indices
+}
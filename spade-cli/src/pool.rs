@@ -0,0 +1,52 @@
+//! Minimal scoped worker pool used by the batch and tiling front ends.
+
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::mpsc;
+use std::thread;
+
+/// Number of worker threads to use when the request does not say.
+pub fn default_threads() -> usize {
+    thread::available_parallelism().map(|n| n.get()).unwrap_or(1)
+}
+
+/// Run `work(i)` for every `i` in `0..count` on up to `threads` workers.
+///
+/// Workers pull the next index from a shared counter, so long and short jobs
+/// balance out. Each result is handed to `sink` on the calling thread as soon as
+/// it is ready, i.e. in completion order rather than index order. At most
+/// `threads` results wait for the sink; beyond that, workers wait for it.
+pub fn for_each_parallel<R, W, S>(count: usize, threads: usize, work: W, mut sink: S)
+where
+    R: Send,
+    W: Fn(usize) -> R + Sync,
+    S: FnMut(usize, R),
+{
+    let threads = threads.clamp(1, count.max(1));
+    if threads == 1 {
+        for i in 0..count {
+            sink(i, work(i));
+        }
+        return;
+    }
+
+    let next = AtomicUsize::new(0);
+    let (tx, rx) = mpsc::sync_channel(threads);
+
+    thread::scope(|scope| {
+        for _ in 0..threads {
+            let tx = tx.clone();
+            let (next, work) = (&next, &work);
+            scope.spawn(move || loop {
+                let i = next.fetch_add(1, Ordering::Relaxed);
+                if i >= count || tx.send((i, work(i))).is_err() {
+                    break;
+                }
+            });
+        }
+        drop(tx);
+
+        for (i, result) in rx {
+            sink(i, result);
+        }
+    });
+}
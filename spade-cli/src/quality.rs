@@ -0,0 +1,160 @@
+//! Mesh quality statistics, requested with `"quality_metrics": true`.
+//!
+//! Computes the same per-triangle measures as `compute_mesh_quality` in the
+//! benchmark harness (minimum angle, longest edge over shortest altitude, area)
+//! and the same histograms, in one parallel pass over the triangles.
+
+use crate::{pool, Input, Output};
+use serde::Serialize;
+use std::time::Instant;
+
+/// Histogram bin edges, as `angle_bins` and `ar_bins` in the harness.
+pub const ANGLE_BINS: [f64; 8] = [0.0, 10.0, 20.0, 30.0, 40.0, 50.0, 60.0, 90.0];
+pub const AR_BINS: [f64; 8] = [1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0, f64::INFINITY];
+
+const CHUNK_TRIANGLES: usize = 64 * 1024;
+
+/// Summary of one measure. Non-finite values (e.g. the aspect ratio of a
+/// zero-area triangle) serialize as `null`.
+#[derive(Serialize)]
+pub struct Stats {
+    pub min: f64,
+    pub max: f64,
+    pub mean: f64,
+    pub median: f64,
+    /// Counts per bin, numpy.histogram semantics; empty for unbinned measures
+    #[serde(skip_serializing_if = "Vec::is_empty")]
+    pub histogram: Vec<u64>,
+}
+
+#[derive(Serialize)]
+pub struct Quality {
+    pub num_triangles: usize,
+    pub total_area: f64,
+    pub min_angle: Stats,
+    pub aspect_ratio: Stats,
+    pub area: Stats,
+    /// Time spent computing these statistics
+    pub elapsed_sec: f64,
+}
+
+/// Per-triangle values of one chunk. Angles and aspect ratios are only
+/// recorded for triangles whose edges all have non-zero length.
+#[derive(Default)]
+struct Measures {
+    min_angles: Vec<f64>,
+    aspect_ratios: Vec<f64>,
+    areas: Vec<f64>,
+}
+
+fn angle_deg(adjacent_a: f64, adjacent_b: f64, opposite: f64) -> f64 {
+    let cos = (adjacent_a * adjacent_a + adjacent_b * adjacent_b - opposite * opposite) / (2.0 * adjacent_a * adjacent_b);
+    cos.clamp(-1.0, 1.0).acos().to_degrees()
+}
+
+fn measure(points: &[[f64; 3]], triangles: &[[usize; 3]]) -> Measures {
+    let mut m = Measures {
+        min_angles: Vec::with_capacity(triangles.len()),
+        aspect_ratios: Vec::with_capacity(triangles.len()),
+        areas: Vec::with_capacity(triangles.len()),
+    };
+    for t in triangles {
+        let (p0, p1, p2) = (points[t[0]], points[t[1]], points[t[2]]);
+        let e0 = [p1[0] - p0[0], p1[1] - p0[1]];
+        let e1 = [p2[0] - p1[0], p2[1] - p1[1]];
+        let e2 = [p0[0] - p2[0], p0[1] - p2[1]];
+        let (l0, l1, l2) = (e0[0].hypot(e0[1]), e1[0].hypot(e1[1]), e2[0].hypot(e2[1]));
+
+        let area = 0.5 * (e0[0] * e2[1] - e0[1] * e2[0]).abs();
+        m.areas.push(area);
+
+        if l0 > 0.0 && l1 > 0.0 && l2 > 0.0 {
+            let min_angle = angle_deg(l0, l2, l1).min(angle_deg(l0, l1, l2)).min(angle_deg(l1, l2, l0));
+            m.min_angles.push(min_angle);
+
+            let max_edge = l0.max(l1).max(l2);
+            let min_altitude = 2.0 * area / max_edge;
+            m.aspect_ratios.push(if min_altitude > 0.0 { max_edge / min_altitude } else { f64::INFINITY });
+        }
+    }
+    m
+}
+
+/// Smallest angle (degrees, infinite without triangles) and largest area over
+/// `triangles`, for reporting the worst triangle left by a truncated refinement.
+pub fn worst_triangle(points: &[[f64; 3]], triangles: &[[usize; 3]]) -> (f64, f64) {
+    let m = measure(points, triangles);
+    let min_angle = m.min_angles.iter().copied().fold(f64::INFINITY, f64::min);
+    let max_area = m.areas.iter().copied().fold(0.0, f64::max);
+    (min_angle, max_area)
+}
+
+fn histogram(values: &[f64], bins: &[f64]) -> Vec<u64> {
+    let (lo, hi) = (bins[0], bins[bins.len() - 1]);
+    let mut counts = vec![0; bins.len() - 1];
+    for &v in values {
+        if v >= lo && v <= hi {
+            // The last bin is closed on the right, as in numpy
+            let i = bins[1..].partition_point(|&edge| edge <= v).min(counts.len() - 1);
+            counts[i] += 1;
+        }
+    }
+    counts
+}
+
+fn stats(mut values: Vec<f64>, bins: Option<&[f64]>) -> Stats {
+    let histogram = bins.map(|bins| histogram(&values, bins)).unwrap_or_default();
+    if values.is_empty() {
+        return Stats { min: 0.0, max: 0.0, mean: 0.0, median: 0.0, histogram };
+    }
+
+    let n = values.len();
+    let min = values.iter().copied().fold(f64::INFINITY, f64::min);
+    let max = values.iter().copied().fold(f64::NEG_INFINITY, f64::max);
+    let mean = values.iter().sum::<f64>() / n as f64;
+
+    let (_, &mut upper, _) = values.select_nth_unstable_by(n / 2, f64::total_cmp);
+    let median = if n % 2 == 1 {
+        upper
+    } else {
+        let lower = values[..n / 2].iter().copied().fold(f64::NEG_INFINITY, f64::max);
+        0.5 * (lower + upper)
+    };
+
+    Stats { min, max, mean, median, histogram }
+}
+
+/// Measure every triangle of `output` on up to `threads` workers.
+pub fn compute(output: &Output, threads: usize) -> Quality {
+    let start = Instant::now();
+    let chunks: Vec<&[[usize; 3]]> = output.triangles.chunks(CHUNK_TRIANGLES).collect();
+
+    let mut parts: Vec<Measures> = Vec::new();
+    parts.resize_with(chunks.len(), Default::default);
+    pool::for_each_parallel(chunks.len(), threads, |i| measure(&output.points, chunks[i]), |i, m| parts[i] = m);
+
+    let mut all = Measures::default();
+    for part in parts {
+        all.min_angles.extend(part.min_angles);
+        all.aspect_ratios.extend(part.aspect_ratios);
+        all.areas.extend(part.areas);
+    }
+
+    let total_area = all.areas.iter().sum();
+    Quality {
+        num_triangles: output.triangles.len(),
+        total_area,
+        min_angle: stats(all.min_angles, Some(&ANGLE_BINS)),
+        aspect_ratio: stats(all.aspect_ratios, Some(&AR_BINS)),
+        area: stats(all.areas, None),
+        elapsed_sec: start.elapsed().as_secs_f64(),
+    }
+}
+
+/// Attach the quality block to `output` if the request asks for it.
+pub fn attach(input: &Input, output: &mut Output) {
+    if input.quality_metrics.unwrap_or(false) {
+        let threads = input.threads.unwrap_or_else(pool::default_threads);
+        output.quality = Some(compute(output, threads));
+    }
+}
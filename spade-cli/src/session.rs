@@ -0,0 +1,736 @@
+//! Editing sessions (`--session`): one triangulation kept alive across edits.
+//!
+//! The first JSON line is a normal request (`enforce_constraints` is implied,
+//! `tile_size` is not supported). It is meshed and answered with a full mesh.
+//! Every further line is one operation on the inner loops:
+//! ```json
+//! {"op": "add_loop", "loop": [[x, y], ...]}          // reply carries the new "loop_id"
+//! {"op": "remove_loop", "loop_id": 3}
+//! {"op": "replace_loop", "loop_id": 3, "loop": [[x, y], ...]}
+//! {"op": "mesh"}                                      // full mesh
+//! ```
+//! The outer loop has id 0 and the request's inner loops have ids 1, 2, ... in
+//! order. The outer loop cannot be edited.
+//!
+//! Vertices have stable ids in the session: a full reply's `points` is indexed
+//! by id, with `null` for unused ids, and triangles and edges refer to ids. An
+//! edit is answered with a diff:
+//! ```json
+//! {"full": false, "removed_point_ids": [...], "added_point_ids": [...], "added_points": [[x, y, 0.0], ...],
+//!  "removed_triangles": [[a, b, c], ...], "added_triangles": [[a, b, c], ...], "elapsed_sec": ...}
+//! ```
+//! Apply the removals first: ids freed by an edit may be reused by it.
+//!
+//! An edit removes every vertex in the box around the old and new loop, widened
+//! by `maxh` or half the loop size. It then re-inserts the loop segments that touch
+//! the box and refines again. Loops are constrained with splitting disabled, as
+//! in `tiling.rs`: segments are pre-split to `maxh`, so re-inserting a piece that
+//! still exists changes nothing. The diff compares the triangles that cross a
+//! second, wider box before and after the edit, found by a walk from the faces
+//! at the box's centre and corners.
+//!
+//! Refinement, or edge flips spreading from the box, can still change the mesh
+//! outside the wider box. A change there either adds vertices, which the vertex
+//! count shows, or spreads through the faces on the rim of the box (those with
+//! a neighbour outside it). The session checks both, and replies with the full
+//! mesh when either changed. Removal, insertion, the diff and the `maxh_min` size
+//! field update scale with the edit. spade's refinement and the hole
+//! classification still scan the whole triangulation once per edit, but only
+//! refine where triangles fail the targets.
+//!
+//! A new loop that touches or overlaps itself or another loop (crossings,
+//! T-contacts, collinear overlaps, shared points) or has coordinates spade
+//! rejects is rejected before anything changes. If an edit still fails halfway,
+//! the session goes back to the previous loops, meshes them from scratch and
+//! replies with that full mesh and the `error`. A panic during an edit ends the
+//! session.
+
+use crate::tiling::subdivide;
+use crate::{estimate_vertices, domain_area, sizing, Cdt, FaceBitSet, Input, Mesher};
+use serde::{Deserialize, Serialize};
+use spade::handles::{FixedFaceHandle, InnerTag};
+use spade::{validate_vertex, Point2, PositionInTriangulation, Triangulation};
+use std::collections::{HashMap, HashSet};
+use std::io::{self, BufRead, Write};
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+type P = [f64; 2];
+
+/// Axis-aligned box `[min_x, min_y, max_x, max_y]`.
+#[derive(Clone, Copy)]
+struct Rect([f64; 4]);
+
+impl Rect {
+    fn around(points: impl IntoIterator<Item = P>) -> Self {
+        let mut r = [f64::INFINITY, f64::INFINITY, f64::NEG_INFINITY, f64::NEG_INFINITY];
+        for [x, y] in points {
+            r = [r[0].min(x), r[1].min(y), r[2].max(x), r[3].max(y)];
+        }
+        Rect(r)
+    }
+
+    fn union(self, other: Rect) -> Self {
+        let (a, b) = (self.0, other.0);
+        Rect([a[0].min(b[0]), a[1].min(b[1]), a[2].max(b[2]), a[3].max(b[3])])
+    }
+
+    fn widen(self, margin: f64) -> Self {
+        let r = self.0;
+        Rect([r[0] - margin, r[1] - margin, r[2] + margin, r[3] + margin])
+    }
+
+    fn extent(self) -> f64 {
+        (self.0[2] - self.0[0]).max(self.0[3] - self.0[1]).max(0.0)
+    }
+
+    fn contains(self, [x, y]: P) -> bool {
+        let r = self.0;
+        x >= r[0] && x <= r[2] && y >= r[1] && y <= r[3]
+    }
+
+    fn overlaps(self, other: Rect) -> bool {
+        let (a, b) = (self.0, other.0);
+        a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3]
+    }
+
+    fn center(self) -> P {
+        [0.5 * (self.0[0] + self.0[2]), 0.5 * (self.0[1] + self.0[3])]
+    }
+
+    /// Whether the triangle `t` (counterclockwise) and the box share a point:
+    /// neither the box axes nor a triangle edge separate them.
+    fn meets_triangle(self, t: [P; 3]) -> bool {
+        if !self.overlaps(Rect::around(t)) {
+            return false;
+        }
+        let r = self.0;
+        let corners = [[r[0], r[1]], [r[2], r[1]], [r[2], r[3]], [r[0], r[3]]];
+        (0..3).all(|i| {
+            let (a, b) = (t[i], t[(i + 1) % 3]);
+            corners.iter().any(|&c| cross(a, b, c) >= 0.0)
+        })
+    }
+}
+
+fn cross(a: P, b: P, c: P) -> f64 {
+    (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0])
+}
+
+/// Whether `p`, collinear with `a`-`b`, lies on that segment.
+fn within(a: P, b: P, p: P) -> bool {
+    p[0] >= a[0].min(b[0]) && p[0] <= a[0].max(b[0]) && p[1] >= a[1].min(b[1]) && p[1] <= a[1].max(b[1])
+}
+
+/// Whether `p` lies on the segment `a`-`b`.
+fn touches(a: P, b: P, p: P) -> bool {
+    cross(a, b, p) == 0.0 && within(a, b, p)
+}
+
+/// Whether segments `a`-`b` and `c`-`d` share a point: they cross, touch or overlap.
+fn segments_meet(a: P, b: P, c: P, d: P) -> bool {
+    let proper = cross(a, b, c) * cross(a, b, d) < 0.0 && cross(c, d, a) * cross(c, d, b) < 0.0;
+    proper || touches(a, b, c) || touches(a, b, d) || touches(c, d, a) || touches(c, d, b)
+}
+
+fn key([x, y]: P) -> (u64, u64) {
+    // `+ 0.0` folds -0.0 into 0.0, as in the triangulation
+    ((x + 0.0).to_bits(), (y + 0.0).to_bits())
+}
+
+#[derive(Clone)]
+struct Loop {
+    points: Vec<P>,
+    bounds: Rect,
+}
+
+impl Loop {
+    fn new(points: Vec<P>) -> Self {
+        Loop { bounds: Rect::around(points.iter().copied()), points }
+    }
+
+    fn segments(&self) -> impl Iterator<Item = (P, P)> + '_ {
+        let n = self.points.len();
+        (0..n).map(move |i| (self.points[i], self.points[(i + 1) % n]))
+    }
+}
+
+#[derive(Deserialize)]
+#[serde(tag = "op", rename_all = "snake_case")]
+enum Op {
+    AddLoop {
+        #[serde(rename = "loop")]
+        points: Vec<P>,
+    },
+    RemoveLoop {
+        loop_id: usize,
+    },
+    ReplaceLoop {
+        loop_id: usize,
+        #[serde(rename = "loop")]
+        points: Vec<P>,
+    },
+    Mesh,
+}
+
+#[derive(Serialize)]
+struct FullReply {
+    full: bool,
+    /// Why an edit failed, when the mesh was rebuilt from the previous loops
+    #[serde(skip_serializing_if = "Option::is_none")]
+    error: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    loop_id: Option<usize>,
+    elapsed_sec: f64,
+    points: Vec<Option<[f64; 3]>>,
+    triangles: Vec<[usize; 3]>,
+    constraint_edges: Vec<[usize; 2]>,
+    loop_ids: Vec<usize>,
+}
+
+#[derive(Serialize)]
+struct DiffReply {
+    full: bool,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    loop_id: Option<usize>,
+    elapsed_sec: f64,
+    removed_point_ids: Vec<usize>,
+    added_point_ids: Vec<usize>,
+    added_points: Vec<[f64; 3]>,
+    removed_triangles: Vec<[usize; 3]>,
+    added_triangles: Vec<[usize; 3]>,
+}
+
+#[derive(Serialize)]
+struct ErrorReply {
+    error: String,
+}
+
+enum Reply {
+    Full(FullReply),
+    Diff(DiffReply),
+}
+
+/// Corner positions of a face by [`key`], smallest first, keeping the orientation.
+type FaceKey = [(u64, u64); 3];
+
+/// In-domain triangles (by vertex id, smallest id first) and vertex positions of
+/// the faces that meet a box.
+struct Snapshot {
+    triangles: HashSet<[usize; 3]>,
+    vertices: HashSet<(u64, u64)>,
+    new_ids: Vec<usize>,
+    /// Every face, with whether it is in the domain
+    faces: HashMap<FaceKey, bool>,
+    /// The faces with a neighbour outside the box
+    rim: Vec<FaceKey>,
+}
+
+struct Session {
+    input: Input,
+    /// Loops by id; removed ones are `None`, id 0 is the outer loop
+    loops: Vec<Option<Loop>>,
+    mesher: Mesher,
+    excluded: FaceBitSet,
+    ids: HashMap<(u64, u64), usize>,
+    positions: Vec<Option<P>>,
+    free_ids: Vec<usize>,
+}
+
+/// Faces of `cdt` that meet `rect`. They form a connected set (the box and the
+/// convex hull are convex), so a walk from the faces at the box centre and corners
+/// finds them all. A corner outside the hull sees a chain of hull edges; if the
+/// hull enters the box across a side, it does so through one of the edges seen
+/// from that side's corners.
+fn faces_meeting(cdt: &Cdt, rect: Rect) -> Vec<FixedFaceHandle<InnerTag>> {
+    let meets = |face: FixedFaceHandle<InnerTag>| {
+        let [a, b, c] = cdt.face(face).positions();
+        rect.meets_triangle([[a.x, a.y], [b.x, b.y], [c.x, c.y]])
+    };
+
+    let r = rect.0;
+    let mut seeds: Vec<FixedFaceHandle<InnerTag>> = Vec::new();
+    for [x, y] in [rect.center(), [r[0], r[1]], [r[2], r[1]], [r[2], r[3]], [r[0], r[3]]] {
+        match cdt.locate(Point2::new(x, y)) {
+            PositionInTriangulation::OnFace(face) => seeds.push(face),
+            PositionInTriangulation::OnVertex(vertex) => seeds
+                .extend(cdt.vertex(vertex).out_edges().filter_map(|e| e.face().as_inner()).map(|f| f.fix())),
+            PositionInTriangulation::OnEdge(edge) => {
+                let edge = cdt.directed_edge(edge);
+                seeds.extend([edge, edge.rev()].into_iter().filter_map(|e| e.face().as_inner()).map(|f| f.fix()));
+            }
+            PositionInTriangulation::OutsideOfConvexHull(edge) => {
+                // The edge has the outer face and the corner on its left; so do its
+                // neighbours along the hull as long as the corner still sees them
+                let visible = |[a, b]: [Point2<f64>; 2]| cross([a.x, a.y], [b.x, b.y], [x, y]) >= 0.0;
+                let start = cdt.directed_edge(edge);
+                seeds.extend(start.rev().face().as_inner().map(|f| f.fix()));
+                let mut e = start.next();
+                while e.fix() != start.fix() && visible(e.positions()) {
+                    seeds.extend(e.rev().face().as_inner().map(|f| f.fix()));
+                    e = e.next();
+                }
+                let mut e = start.prev();
+                while e.fix() != start.fix() && visible(e.positions()) {
+                    seeds.extend(e.rev().face().as_inner().map(|f| f.fix()));
+                    e = e.prev();
+                }
+            }
+            PositionInTriangulation::NoTriangulation => {}
+        }
+    }
+
+    let mut seen = HashSet::new();
+    seeds.retain(|&face| meets(face) && seen.insert(face.index()));
+    let mut faces = Vec::new();
+    while let Some(face) = seeds.pop() {
+        faces.push(face);
+        for edge in cdt.face(face).adjacent_edges() {
+            if let Some(neighbor) = edge.rev().face().as_inner() {
+                let neighbor = neighbor.fix();
+                if !seen.contains(&neighbor.index()) && meets(neighbor) {
+                    seen.insert(neighbor.index());
+                    seeds.push(neighbor);
+                }
+            }
+        }
+    }
+    faces
+}
+
+/// Rotate a triangle so that its smallest id comes first, keeping the orientation.
+fn canonical(t: [usize; 3]) -> [usize; 3] {
+    let i = (0..3).min_by_key(|&i| t[i]).unwrap();
+    [t[i], t[(i + 1) % 3], t[(i + 2) % 3]]
+}
+
+fn face_key(t: [Point2<f64>; 3]) -> FaceKey {
+    let keys = t.map(|p| key([p.x, p.y]));
+    let i = (0..3).min_by_key(|&i| keys[i]).unwrap();
+    [keys[i], keys[(i + 1) % 3], keys[(i + 2) % 3]]
+}
+
+/// Mesh `loops` (outer first) as the session's `input` asks, with the loop
+/// segments pre-split to `maxh`.
+fn mesh_loops(input: &Input, loops: &[Option<Loop>]) -> Result<(Mesher, FaceBitSet), String> {
+    let mut vertices = Vec::new();
+    let mut edges = Vec::new();
+    for lp in loops.iter().flatten() {
+        for (a, b) in lp.segments() {
+            let mut points = vec![a];
+            subdivide(a, b, input.maxh, &mut points);
+            points.push(b);
+            for w in points.windows(2) {
+                edges.push([vertices.len(), vertices.len() + 1]);
+                vertices.push(Point2::new(w[0][0], w[0][1]));
+                vertices.push(Point2::new(w[1][0], w[1][1]));
+            }
+        }
+    }
+    let expected_vertices = estimate_vertices(vertices.len(), domain_area(input), input.maxh);
+    let mut mesher = Mesher::from_pslg(input, vertices, edges, expected_vertices).map_err(|e| e.to_string())?;
+    mesher.keep_constraint_edges = true;
+    mesher.size_field = sizing::SizeField::from_input(input)?.map(Arc::new);
+    let excluded = mesher.refine(input, input.maxh);
+    Ok((mesher, excluded))
+}
+
+impl Session {
+    /// Mesh the first request of a session.
+    fn start(mut input: Input) -> Result<(Self, FullReply), String> {
+        let start = Instant::now();
+        if input.tile_size.is_some() {
+            return Err("tile_size is not supported in sessions".into());
+        }
+        input.enforce_constraints = true;
+
+        let loops: Vec<Option<Loop>> = std::iter::once(&input.outer)
+            .chain(&input.inner_loops)
+            .map(|points| Some(Loop::new(points.clone())))
+            .collect();
+
+        let (mesher, excluded) = mesh_loops(&input, &loops)?;
+
+        let mut session = Session {
+            input,
+            loops,
+            mesher,
+            excluded,
+            ids: HashMap::new(),
+            positions: Vec::new(),
+            free_ids: Vec::new(),
+        };
+        session.resync_ids();
+        let reply = session.full_reply(None, start);
+        Ok((session, reply))
+    }
+
+    fn cdt(&self) -> &Cdt {
+        &self.mesher.cdt
+    }
+
+    fn id_of(&self, p: Point2<f64>) -> usize {
+        self.ids[&key([p.x, p.y])]
+    }
+
+    fn allocate_id(&mut self, p: P) -> usize {
+        let id = self.free_ids.pop().unwrap_or_else(|| {
+            self.positions.push(None);
+            self.positions.len() - 1
+        });
+        self.positions[id] = Some(p);
+        self.ids.insert(key(p), id);
+        id
+    }
+
+    fn free_id(&mut self, k: (u64, u64)) -> Option<usize> {
+        let id = self.ids.remove(&k)?;
+        self.positions[id] = None;
+        self.free_ids.push(id);
+        Some(id)
+    }
+
+    /// Bring the ids in line with the whole triangulation, keeping the ids of
+    /// vertices that still exist.
+    fn resync_ids(&mut self) {
+        let present: HashMap<(u64, u64), P> = self
+            .cdt()
+            .vertices()
+            .map(|v| {
+                let p = v.position();
+                (key([p.x, p.y]), [p.x, p.y])
+            })
+            .collect();
+        let gone: Vec<(u64, u64)> = self.ids.keys().filter(|k| !present.contains_key(k)).copied().collect();
+        for k in gone {
+            self.free_id(k);
+        }
+        let mut added: Vec<P> = present.iter().filter(|(k, _)| !self.ids.contains_key(k)).map(|(_, &p)| p).collect();
+        // Hash order is arbitrary; number new vertices by position instead
+        added.sort_by(|a, b| a[0].total_cmp(&b[0]).then(a[1].total_cmp(&b[1])));
+        for p in added {
+            self.allocate_id(p);
+        }
+    }
+
+    fn full_reply(&self, loop_id: Option<usize>, start: Instant) -> FullReply {
+        let cdt = self.cdt();
+        let triangles = cdt
+            .inner_faces()
+            .filter(|face| !self.excluded.contains(face.fix().index()))
+            .map(|face| face.positions().map(|p| self.id_of(p)))
+            .collect();
+        let constraint_edges = cdt
+            .undirected_edges()
+            .filter(|edge| edge.is_constraint_edge())
+            .map(|edge| edge.positions().map(|p| self.id_of(p)))
+            .collect();
+        FullReply {
+            full: true,
+            error: None,
+            loop_id,
+            elapsed_sec: start.elapsed().as_secs_f64(),
+            points: self.positions.iter().map(|p| p.map(|[x, y]| [x, y, 0.0])).collect(),
+            triangles,
+            constraint_edges,
+            loop_ids: (0..self.loops.len()).filter(|&id| self.loops[id].is_some()).collect(),
+        }
+    }
+
+    /// Triangles and vertices of the faces meeting `rect`. Vertices without an id
+    /// get one, returned in the snapshot.
+    fn snapshot(&mut self, rect: Rect) -> Snapshot {
+        let faces = faces_meeting(self.cdt(), rect);
+        let mut vertices = HashSet::new();
+        let mut new_vertices = Vec::new();
+        for &face in &faces {
+            for p in self.cdt().face(face).positions() {
+                let k = key([p.x, p.y]);
+                if vertices.insert(k) && !self.ids.contains_key(&k) {
+                    new_vertices.push([p.x, p.y]);
+                }
+            }
+        }
+        new_vertices.sort_by(|a, b| a[0].total_cmp(&b[0]).then(a[1].total_cmp(&b[1])));
+        let new_ids = new_vertices.into_iter().map(|p| self.allocate_id(p)).collect();
+
+        let cdt = self.cdt();
+        let inside: HashSet<usize> = faces.iter().map(|f| f.index()).collect();
+        let mut triangles = HashSet::new();
+        let mut keys = HashMap::new();
+        let mut rim = Vec::new();
+        for &face in &faces {
+            let handle = cdt.face(face);
+            let in_domain = !self.excluded.contains(face.index());
+            if in_domain {
+                triangles.insert(canonical(handle.positions().map(|p| self.id_of(p))));
+            }
+            let k = face_key(handle.positions());
+            keys.insert(k, in_domain);
+            let outside = handle.adjacent_edges().iter().any(|e| {
+                matches!(e.rev().face().as_inner(), Some(neighbor) if !inside.contains(&neighbor.fix().index()))
+            });
+            if outside {
+                rim.push(k);
+            }
+        }
+        Snapshot { triangles, vertices, new_ids, faces: keys, rim }
+    }
+
+    /// Reject a loop that is degenerate, has coordinates spade rejects, or meets
+    /// itself or another live loop anywhere but at its own corners.
+    fn check_loop(&self, points: &[P], replacing: Option<usize>) -> Result<(), String> {
+        if points.len() < 3 {
+            return Err("a loop needs at least three vertices".into());
+        }
+        let new = Loop::new(points.to_vec());
+        let segments: Vec<(P, P)> = new.segments().collect();
+        for &(a, b) in &segments {
+            if a == b {
+                return Err("the loop repeats a vertex".into());
+            }
+            // The pieces are what gets inserted
+            let mut pieces = vec![a];
+            subdivide(a, b, self.input.maxh, &mut pieces);
+            for [x, y] in pieces {
+                validate_vertex(&Point2::new(x, y)).map_err(|e| format!("loop vertex ({}, {}): {}", x, y, e))?;
+            }
+        }
+        let n = segments.len();
+        for i in 0..n {
+            for j in i + 1..n {
+                let ((a, b), (c, d)) = (segments[i], segments[j]);
+                // Neighbours share a corner and only conflict if one folds back onto the other
+                let meet = if j == i + 1 {
+                    touches(a, b, d) || touches(c, d, a)
+                } else if i == 0 && j == n - 1 {
+                    touches(a, b, c) || touches(c, d, b)
+                } else {
+                    segments_meet(a, b, c, d)
+                };
+                if meet {
+                    return Err("the loop touches itself".into());
+                }
+            }
+        }
+        for (id, other) in self.loops.iter().enumerate() {
+            let Some(other) = other.as_ref().filter(|_| Some(id) != replacing) else { continue };
+            if !other.bounds.overlaps(new.bounds) {
+                continue;
+            }
+            for (c, d) in other.segments() {
+                if segments.iter().any(|&(a, b)| segments_meet(a, b, c, d)) {
+                    return Err(format!("the loop touches loop {}", id));
+                }
+            }
+        }
+        Ok(())
+    }
+
+    /// Clear `cleared`, re-insert the loop pieces that meet it and refine.
+    fn remesh(&mut self, cleared: Rect) -> Result<(), String> {
+        // Remove the box's vertices, looking each one up again because removal
+        // renumbers the handles
+        let doomed: Vec<P> = faces_meeting(self.cdt(), cleared)
+            .into_iter()
+            .flat_map(|face| self.cdt().face(face).positions())
+            .map(|p| [p.x, p.y])
+            .filter(|&p| cleared.contains(p))
+            .map(|p| (key(p), p))
+            .collect::<HashMap<_, _>>()
+            .into_values()
+            .collect();
+        for p in doomed {
+            if let Some(vertex) = self.mesher.cdt.locate_vertex(Point2::new(p[0], p[1])) {
+                let vertex = vertex.fix();
+                self.mesher.cdt.remove(vertex);
+            }
+        }
+
+        // Re-insert every (pre-split) segment near the box; pieces that survived
+        // are already constraint edges
+        let maxh = self.input.maxh;
+        let cdt = &mut self.mesher.cdt;
+        for lp in self.loops.iter().flatten().filter(|lp| lp.bounds.overlaps(cleared)) {
+            for (a, b) in lp.segments() {
+                if !Rect::around([a, b]).overlaps(cleared) {
+                    continue;
+                }
+                let mut pieces = vec![a];
+                subdivide(a, b, maxh, &mut pieces);
+                pieces.push(b);
+                for w in pieces.windows(2) {
+                    let from = cdt.insert(Point2::new(w[0][0], w[0][1])).map_err(|e| e.to_string())?;
+                    let to = cdt.insert(Point2::new(w[1][0], w[1][1])).map_err(|e| e.to_string())?;
+                    if !cdt.can_add_constraint(from, to) {
+                        return Err(format!("segment {:?}-{:?} crosses a constraint edge", w[0], w[1]));
+                    }
+                    cdt.add_constraint(from, to);
+                }
+            }
+        }
+
+        self.mesher.vertex_budget = self.input.max_additional_vertices;
+        self.mesher.deadline = self.input.deadline_ms.map(|ms| Instant::now() + Duration::from_millis(ms));
+        self.excluded = self.mesher.refine(&self.input, maxh);
+        Ok(())
+    }
+
+    /// Put `lp` in slot `id`, a new slot when `id` is the loop count, and return
+    /// what was there. The input keeps one inner loop per id, empty once removed,
+    /// and the size field follows the loops.
+    fn set_loop(&mut self, id: usize, lp: Option<Loop>) -> Option<Loop> {
+        let points = lp.as_ref().map(|lp| lp.points.clone()).unwrap_or_default();
+        if let Some(field) = self.mesher.size_field.as_mut() {
+            let field = Arc::make_mut(field);
+            if let Some(old) = self.loops.get(id).and_then(Option::as_ref) {
+                field.remove_loop(&old.points);
+            }
+            field.insert_loop(&points);
+        }
+        if id == self.loops.len() {
+            self.loops.push(lp);
+            self.input.inner_loops.push(points);
+            None
+        } else {
+            self.input.inner_loops[id - 1] = points;
+            std::mem::replace(&mut self.loops[id], lp)
+        }
+    }
+
+    /// Replace loop `loop_id` (or add a loop when `None`) with `points` (or
+    /// remove it when `None`), re-mesh around it and return the diff.
+    fn edit(&mut self, loop_id: Option<usize>, points: Option<Vec<P>>) -> Result<Reply, String> {
+        let start = Instant::now();
+        let old = match loop_id {
+            Some(0) => return Err("the outer loop cannot be edited".into()),
+            Some(id) => Some(
+                self.loops.get(id).and_then(Option::as_ref).ok_or_else(|| format!("no loop {}", id))?.bounds,
+            ),
+            None => None,
+        };
+        if let Some(points) = &points {
+            self.check_loop(points, loop_id)?;
+        }
+        let new = points.as_ref().map(|p| Rect::around(p.iter().copied()));
+        let changed = match (old, new) {
+            (Some(a), Some(b)) => a.union(b),
+            (Some(r), None) | (None, Some(r)) => r,
+            (None, None) => unreachable!(),
+        };
+        let margin = self.input.maxh.unwrap_or(0.0).max(0.5 * changed.extent());
+        let cleared = changed.widen(margin);
+        let window = cleared.widen(margin);
+
+        let before = self.snapshot(window);
+        let added = loop_id.is_none();
+        let loop_id = loop_id.unwrap_or(self.loops.len());
+        let replaced = self.set_loop(loop_id, points.map(Loop::new));
+        if let Err(error) = self.remesh(cleared) {
+            // The mesh is half edited: go back to the previous loops from scratch
+            if added {
+                self.loops.pop();
+                self.input.inner_loops.pop();
+            } else {
+                self.input.inner_loops[loop_id - 1] = replaced.as_ref().map(|lp| lp.points.clone()).unwrap_or_default();
+                self.loops[loop_id] = replaced;
+            }
+            (self.mesher, self.excluded) =
+                mesh_loops(&self.input, &self.loops).expect("the previous loops were meshed before");
+            self.resync_ids();
+            let mut reply = self.full_reply(None, start);
+            reply.error = Some(error);
+            return Ok(Reply::Full(reply));
+        }
+
+        // Vertices of the old window that are gone free their ids before the new
+        // vertices take theirs
+        let gone: Vec<(u64, u64)> = before
+            .vertices
+            .iter()
+            .filter(|k| {
+                let p = Point2::new(f64::from_bits(k.0), f64::from_bits(k.1));
+                self.cdt().locate_vertex(p).is_none()
+            })
+            .copied()
+            .collect();
+        let mut removed_point_ids: Vec<usize> = gone.into_iter().filter_map(|k| self.free_id(k)).collect();
+        removed_point_ids.sort_unstable();
+        let after = self.snapshot(window);
+        let added_point_ids = after.new_ids;
+
+        // A change outside the window adds vertices or reaches it through the rim
+        let rim_kept = before.rim.iter().all(|k| after.faces.get(k) == before.faces.get(k));
+        if !rim_kept || self.ids.len() != self.cdt().num_vertices() {
+            self.resync_ids();
+            return Ok(Reply::Full(self.full_reply(Some(loop_id), start)));
+        }
+
+        let removed_triangles: Vec<[usize; 3]> = before.triangles.difference(&after.triangles).copied().collect();
+        let added_triangles: Vec<[usize; 3]> = after.triangles.difference(&before.triangles).copied().collect();
+        let added_points = added_point_ids.iter().map(|&id| {
+            let [x, y] = self.positions[id].unwrap();
+            [x, y, 0.0]
+        });
+        Ok(Reply::Diff(DiffReply {
+            full: false,
+            loop_id: Some(loop_id),
+            elapsed_sec: start.elapsed().as_secs_f64(),
+            added_points: added_points.collect(),
+            removed_point_ids,
+            added_point_ids,
+            removed_triangles,
+            added_triangles,
+        }))
+    }
+
+    fn apply(&mut self, op: Op) -> Result<Reply, String> {
+        match op {
+            Op::AddLoop { points } => self.edit(None, Some(points)),
+            Op::RemoveLoop { loop_id } => self.edit(Some(loop_id), None),
+            Op::ReplaceLoop { loop_id, points } => self.edit(Some(loop_id), Some(points)),
+            Op::Mesh => Ok(Reply::Full(self.full_reply(None, Instant::now()))),
+        }
+    }
+}
+
+fn write_line<W: Write, T: Serialize>(out: &mut W, reply: &T) -> io::Result<()> {
+    serde_json::to_writer(&mut *out, reply)?;
+    writeln!(out)?;
+    out.flush()
+}
+
+/// Run a session over JSON lines from `input`, one reply line per line.
+pub fn run_session<R: BufRead, W: Write>(input: R, out: &mut W) -> io::Result<()> {
+    let mut lines = input.lines().filter(|line| !matches!(line, Ok(l) if l.trim().is_empty()));
+    let Some(first) = lines.next() else { return Ok(()) };
+    let started = serde_json::from_str::<Input>(&first?)
+        .map_err(|e| e.to_string())
+        .and_then(|input| {
+            panic::catch_unwind(|| Session::start(input)).unwrap_or_else(|_| Err("triangulation panicked".into()))
+        });
+    let mut session = match started {
+        Ok((session, reply)) => {
+            write_line(out, &reply)?;
+            session
+        }
+        Err(error) => return write_line(out, &ErrorReply { error }),
+    };
+
+    for line in lines {
+        let result = serde_json::from_str::<Op>(&line?).map_err(|e| e.to_string()).map(|op| {
+            panic::catch_unwind(AssertUnwindSafe(|| session.apply(op)))
+        });
+        match result {
+            Ok(Ok(Ok(Reply::Full(reply)))) => write_line(out, &reply)?,
+            Ok(Ok(Ok(Reply::Diff(reply)))) => write_line(out, &reply)?,
+            Ok(Ok(Err(error))) | Err(error) => write_line(out, &ErrorReply { error })?,
+            Ok(Err(_)) => {
+                // The triangulation may be half edited
+                return write_line(out, &ErrorReply { error: "edit panicked; session ended".into() });
+            }
+        }
+    }
+    Ok(())
+}
@@ -0,0 +1,127 @@
+//! Graded target size, enabled by `"maxh_min"` in the request.
+//!
+//! The target edge length is `maxh_min` on the input loops and grows by
+//! `maxh_growth` per unit distance from the nearest loop edge, up to `maxh`.
+//! spade's refinement only knows one maximum area, so [`Mesher::refine`] first
+//! inserts triangle centroids wherever a triangle is larger than the field allows
+//! at its centroid, and then lets spade enforce the angle limit and `maxh` as usual.
+//!
+//! [`Mesher::refine`]: crate::Mesher::refine
+
+use crate::cleanup::segment_dist2;
+use crate::Input;
+use std::collections::HashMap;
+
+type P = [f64; 2];
+
+/// Default size increase per unit distance from the loops
+pub const DEFAULT_GROWTH: f64 = 0.25;
+
+/// Target edge length by distance to the input loops. Loop edges are cut into
+/// pieces no longer than a grid cell and bucketed by their midpoint, so a query
+/// only looks at the cells within the distance where the size reaches `max`.
+#[derive(Clone)]
+pub struct SizeField {
+    min: f64,
+    max: f64,
+    growth: f64,
+    /// Distance from the loops beyond which the size is `max`
+    reach: f64,
+    cell: f64,
+    cells: HashMap<(i64, i64), Vec<[P; 2]>>,
+}
+
+impl SizeField {
+    /// The size field `input` asks for, or `None` without `maxh_min` and `maxh`.
+    pub fn from_input(input: &Input) -> Result<Option<Self>, String> {
+        let (Some(min), Some(max)) = (input.maxh_min, input.maxh) else {
+            return Ok(None);
+        };
+        let growth = input.maxh_growth.unwrap_or(DEFAULT_GROWTH);
+        if !(min > 0.0 && min <= max && growth > 0.0) {
+            return Err("maxh_min needs 0 < maxh_min <= maxh and a positive maxh_growth".into());
+        }
+
+        let reach = (max - min) / growth;
+        // About five cells across the reach keeps queries to a few dozen cells
+        let cell = (reach / 4.0).max(min);
+        let mut field = SizeField { min, max, growth, reach, cell, cells: HashMap::new() };
+
+        for lp in std::iter::once(&input.outer).chain(&input.inner_loops) {
+            field.insert_loop(lp);
+        }
+        Ok(Some(field))
+    }
+
+    /// Add the edges of the closed loop `lp`.
+    pub fn insert_loop(&mut self, lp: &[P]) {
+        for (i, &a) in lp.iter().enumerate() {
+            self.insert_edge(a, lp[(i + 1) % lp.len()]);
+        }
+    }
+
+    /// Remove the edges [`SizeField::insert_loop`] added for `lp`.
+    pub fn remove_loop(&mut self, lp: &[P]) {
+        for (i, &a) in lp.iter().enumerate() {
+            for (key, piece) in self.pieces(a, lp[(i + 1) % lp.len()]) {
+                if let Some(cell) = self.cells.get_mut(&key) {
+                    if let Some(at) = cell.iter().position(|&p| p == piece) {
+                        cell.swap_remove(at);
+                    }
+                    if cell.is_empty() {
+                        self.cells.remove(&key);
+                    }
+                }
+            }
+        }
+    }
+
+    fn cell_of(&self, p: P) -> (i64, i64) {
+        ((p[0] / self.cell).floor() as i64, (p[1] / self.cell).floor() as i64)
+    }
+
+    /// The pieces of edge `a`-`b` with their cells.
+    fn pieces(&self, a: P, b: P) -> Vec<((i64, i64), [P; 2])> {
+        let len = (b[0] - a[0]).hypot(b[1] - a[1]);
+        let pieces = ((len / self.cell).ceil() as usize).max(1);
+        let at = |k: usize| {
+            let t = k as f64 / pieces as f64;
+            [a[0] + t * (b[0] - a[0]), a[1] + t * (b[1] - a[1])]
+        };
+        (0..pieces)
+            .map(|k| {
+                let (p, q) = (at(k), at(k + 1));
+                (self.cell_of([0.5 * (p[0] + q[0]), 0.5 * (p[1] + q[1])]), [p, q])
+            })
+            .collect()
+    }
+
+    fn insert_edge(&mut self, a: P, b: P) {
+        for (key, piece) in self.pieces(a, b) {
+            self.cells.entry(key).or_default().push(piece);
+        }
+    }
+
+    /// Distance from `p` to the nearest loop edge, capped at the reach.
+    fn distance(&self, p: P) -> f64 {
+        // A piece within the reach has its midpoint within reach + cell / 2
+        let radius = ((self.reach + 0.5 * self.cell) / self.cell).ceil() as i64;
+        let (cx, cy) = self.cell_of(p);
+        let mut best = self.reach * self.reach;
+        for dx in -radius..=radius {
+            for dy in -radius..=radius {
+                if let Some(pieces) = self.cells.get(&(cx + dx, cy + dy)) {
+                    for &[a, b] in pieces {
+                        best = best.min(segment_dist2(p, a, b));
+                    }
+                }
+            }
+        }
+        best.sqrt()
+    }
+
+    /// Target edge length at `p`.
+    pub fn size_at(&self, p: P) -> f64 {
+        (self.min + self.growth * self.distance(p)).min(self.max)
+    }
+}
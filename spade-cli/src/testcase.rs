@@ -0,0 +1,75 @@
+//! Reader for the harness' testcase format, used by `spade-cli --testcase <path>`.
+//!
+//! One loop per line as whitespace-separated `x0 y0 x1 y1 ...`; the first line is
+//! the outer loop and every further non-blank line an inner loop, as in the
+//! harness' `load_testcase`. The file is read with a single `read` and parsed in
+//! place, in parallel chunks of lines. Tokens go straight from bytes to
+//! `f64::from_str`, which implements the Eisel–Lemire fast path.
+
+use crate::pool;
+
+type Loop = Vec<[f64; 2]>;
+
+/// Lines are handed to workers in chunks of about this many bytes
+const CHUNK_BYTES: usize = 1 << 20;
+
+fn parse_loop(line: &[u8], line_number: usize) -> Result<Loop, String> {
+    let mut coords = Vec::with_capacity(line.len() / 16);
+    for token in line.split(u8::is_ascii_whitespace).filter(|t| !t.is_empty()) {
+        let value = std::str::from_utf8(token).ok().and_then(|t| t.parse::<f64>().ok());
+        coords.push(value.ok_or_else(|| {
+            format!("line {}: invalid number {:?}", line_number, String::from_utf8_lossy(token))
+        })?);
+    }
+    if coords.len() % 2 != 0 {
+        return Err(format!("line {}: odd number of coordinates", line_number));
+    }
+    Ok(coords.chunks_exact(2).map(|c| [c[0], c[1]]).collect())
+}
+
+/// Split testcase text into the outer loop and the inner loops.
+pub fn parse(data: &[u8], threads: usize) -> Result<(Loop, Vec<Loop>), String> {
+    let lines: Vec<&[u8]> = data.split(|&b| b == b'\n').collect();
+
+    // Chunk boundaries as line indices
+    let mut bounds = vec![0];
+    let mut bytes = 0;
+    for (i, line) in lines.iter().enumerate() {
+        bytes += line.len() + 1;
+        if bytes >= CHUNK_BYTES {
+            bounds.push(i + 1);
+            bytes = 0;
+        }
+    }
+    if *bounds.last().unwrap() < lines.len() {
+        bounds.push(lines.len());
+    }
+
+    let mut chunks: Vec<Result<Vec<Loop>, String>> = Vec::new();
+    chunks.resize_with(bounds.len() - 1, || Ok(Vec::new()));
+    pool::for_each_parallel(
+        chunks.len(),
+        threads,
+        |c| {
+            (bounds[c]..bounds[c + 1])
+                .filter(|&i| i == 0 || lines[i].iter().any(|b| !b.is_ascii_whitespace()))
+                .map(|i| parse_loop(lines[i], i + 1))
+                .collect()
+        },
+        |c, loops| chunks[c] = loops,
+    );
+
+    let mut loops = Vec::new();
+    for chunk in chunks {
+        loops.extend(chunk?);
+    }
+    let mut loops = loops.into_iter();
+    let outer = loops.next().unwrap_or_default();
+    Ok((outer, loops.collect()))
+}
+
+/// Read and parse the testcase file at `path`.
+pub fn read(path: &str, threads: usize) -> Result<(Loop, Vec<Loop>), String> {
+    let data = std::fs::read(path).map_err(|e| format!("{}: {}", path, e))?;
+    parse(&data, threads)
+}
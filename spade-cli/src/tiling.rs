@@ -0,0 +1,355 @@
+//! Tiled domain decomposition, enabled by `"tile_size"` in the request.
+//!
+//! The domain is cut along a square grid. Loop segments are split where they cross
+//! a grid line, and the parts of each grid line that lie inside the domain become
+//! shared constraint edges between the two neighbouring tiles. Every crossing and
+//! seam vertex is computed once per grid line, so both neighbours insert bit-identical
+//! points. Tiles are meshed independently in parallel with constraint splitting
+//! disabled (constraints are pre-split to `maxh` instead), which keeps the seams
+//! conforming, and the tile meshes are merged with shared vertices numbered once.
+//!
+//! Peak CDT memory is bounded by the largest tile times the number of threads.
+//! Hole classification relies on even-odd parity, so tiling requires
+//! `enforce_constraints` with `exclude_holes`.
+//! `max_additional_vertices` is split evenly between the non-empty tiles, and
+//! `deadline_ms` is one deadline for all of them, counted from the start of tiling.
+
+use crate::sizing::SizeField;
+use crate::{estimate_vertices, pool, Input, Mesher, Output};
+use spade::Point2;
+use std::collections::HashMap;
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+/// Grid lines `x0 + i * size` and `y0 + j * size`; tile `(i, j)` spans lines i..i+1, j..j+1.
+struct Grid {
+    x0: f64,
+    y0: f64,
+    size: f64,
+    nx: usize,
+    ny: usize,
+}
+
+impl Grid {
+    fn x(&self, i: usize) -> f64 {
+        self.x0 + i as f64 * self.size
+    }
+
+    fn y(&self, j: usize) -> f64 {
+        self.y0 + j as f64 * self.size
+    }
+
+    fn column(&self, x: f64) -> usize {
+        (((x - self.x0) / self.size).floor().max(0.0) as usize).min(self.nx - 1)
+    }
+
+    fn row(&self, y: f64) -> usize {
+        (((y - self.y0) / self.size).floor().max(0.0) as usize).min(self.ny - 1)
+    }
+
+    fn tile(&self, i: usize, j: usize) -> usize {
+        j * self.nx + i
+    }
+
+    /// True if `a` and `b` both lie exactly on the same grid line, i.e. the edge
+    /// between them is a seam rather than part of an input loop.
+    fn is_seam(&self, a: [f64; 3], b: [f64; 3]) -> bool {
+        let on_line = |v: f64, origin: f64| {
+            let k = ((v - origin) / self.size).round();
+            (k >= 0.0 && origin + k * self.size == v).then_some(k)
+        };
+        let same_line = |va: f64, vb: f64, origin: f64| match (on_line(va, origin), on_line(vb, origin)) {
+            (Some(ka), Some(kb)) => ka == kb,
+            _ => false,
+        };
+        same_line(a[0], b[0], self.x0) || same_line(a[1], b[1], self.y0)
+    }
+}
+
+/// Pick the grid offset along one axis that keeps input coordinates farthest from
+/// any grid line, so no vertex or segment lies on a seam and all crossings are proper.
+fn choose_origin(coords: impl Iterator<Item = f64> + Clone, min: f64, size: f64) -> f64 {
+    const CANDIDATES: usize = 32;
+    let mut best = (f64::NEG_INFINITY, min - 0.5 * size);
+    for k in 1..CANDIDATES {
+        let origin = min - size * k as f64 / CANDIDATES as f64;
+        let clearance = coords
+            .clone()
+            .map(|v| {
+                let f = ((v - origin) / size).fract();
+                f.min(1.0 - f)
+            })
+            .fold(f64::INFINITY, f64::min);
+        if clearance > best.0 {
+            best = (clearance, origin);
+        }
+    }
+    best.1
+}
+
+/// Points strictly between `a` and `b` that split the segment into pieces no
+/// longer than `maxh`.
+pub(crate) fn subdivide(a: [f64; 2], b: [f64; 2], maxh: Option<f64>, out: &mut Vec<[f64; 2]>) {
+    let Some(maxh) = maxh.filter(|h| *h > 0.0) else { return };
+    let len = ((b[0] - a[0]).powi(2) + (b[1] - a[1]).powi(2)).sqrt();
+    let n = (len / maxh).ceil() as usize;
+    for k in 1..n {
+        let t = k as f64 / n as f64;
+        out.push([a[0] + t * (b[0] - a[0]), a[1] + t * (b[1] - a[1])]);
+    }
+}
+
+/// Sort the crossings of one grid line and call `emit` for every inside span,
+/// split at the positions returned by `stops_between`.
+fn seam_spans(crossings: &mut [f64], stops_between: impl Fn(f64, f64) -> Vec<f64>, mut emit: impl FnMut(f64, f64)) {
+    crossings.sort_by(f64::total_cmp);
+    for span in crossings.chunks_exact(2) {
+        let mut stops = vec![span[0]];
+        stops.extend(stops_between(span[0], span[1]));
+        stops.push(span[1]);
+        for w in stops.windows(2) {
+            emit(w[0], w[1]);
+        }
+    }
+}
+
+/// Constraint segments of every tile, indexed by [`Grid::tile`].
+fn decompose(loops: &[&[[f64; 2]]], grid: &Grid, maxh: Option<f64>) -> Vec<Vec<[[f64; 2]; 2]>> {
+    let mut tiles = vec![Vec::new(); grid.nx * grid.ny];
+    // Positions where loops cross vertical line i (as y) and horizontal line j (as x)
+    let mut vertical = vec![Vec::new(); grid.nx + 1];
+    let mut horizontal = vec![Vec::new(); grid.ny + 1];
+
+    let push_piece = |tiles: &mut Vec<Vec<[[f64; 2]; 2]>>, a: [f64; 2], b: [f64; 2]| {
+        let mid = [0.5 * (a[0] + b[0]), 0.5 * (a[1] + b[1])];
+        let tile = grid.tile(grid.column(mid[0]), grid.row(mid[1]));
+        let mut points = vec![a];
+        subdivide(a, b, maxh, &mut points);
+        points.push(b);
+        for w in points.windows(2) {
+            tiles[tile].push([w[0], w[1]]);
+        }
+    };
+
+    // Split loop segments at grid crossings
+    for lp in loops {
+        for k in 0..lp.len() {
+            let (a, b) = (lp[k], lp[(k + 1) % lp.len()]);
+            if a == b {
+                continue;
+            }
+
+            let mut cuts: Vec<(f64, [f64; 2])> = Vec::new();
+            let (ca, cb) = (grid.column(a[0]), grid.column(b[0]));
+            for i in ca.min(cb) + 1..=ca.max(cb) {
+                let x = grid.x(i);
+                let t = (x - a[0]) / (b[0] - a[0]);
+                let p = [x, a[1] + t * (b[1] - a[1])];
+                vertical[i].push(p[1]);
+                cuts.push((t, p));
+            }
+            let (ra, rb) = (grid.row(a[1]), grid.row(b[1]));
+            for j in ra.min(rb) + 1..=ra.max(rb) {
+                let y = grid.y(j);
+                let t = (y - a[1]) / (b[1] - a[1]);
+                let p = [a[0] + t * (b[0] - a[0]), y];
+                horizontal[j].push(p[0]);
+                cuts.push((t, p));
+            }
+            cuts.sort_by(|u, v| u.0.total_cmp(&v.0));
+
+            let mut from = a;
+            for (_, p) in cuts {
+                push_piece(&mut tiles, from, p);
+                from = p;
+            }
+            push_piece(&mut tiles, from, b);
+        }
+    }
+
+    // Seams: walking along a grid line from outside the domain, every crossing
+    // toggles inside/outside (even-odd). Inside spans are split at the other
+    // family's grid lines (tile corners) and shared by the tiles on both sides.
+    for i in 1..grid.nx {
+        let x = grid.x(i);
+        let rows = |lo: f64, hi: f64| (0..=grid.ny).map(|j| grid.y(j)).filter(|&y| y > lo && y < hi).collect();
+        seam_spans(&mut vertical[i], rows, |lo, hi| {
+            let (a, b) = ([x, lo], [x, hi]);
+            let mut points = vec![a];
+            subdivide(a, b, maxh, &mut points);
+            points.push(b);
+            let j = grid.row(0.5 * (lo + hi));
+            for w in points.windows(2) {
+                tiles[grid.tile(i - 1, j)].push([w[0], w[1]]);
+                tiles[grid.tile(i, j)].push([w[0], w[1]]);
+            }
+        });
+    }
+    for j in 1..grid.ny {
+        let y = grid.y(j);
+        let columns = |lo: f64, hi: f64| (0..=grid.nx).map(|i| grid.x(i)).filter(|&x| x > lo && x < hi).collect();
+        seam_spans(&mut horizontal[j], columns, |lo, hi| {
+            let (a, b) = ([lo, y], [hi, y]);
+            let mut points = vec![a];
+            subdivide(a, b, maxh, &mut points);
+            points.push(b);
+            let i = grid.column(0.5 * (lo + hi));
+            for w in points.windows(2) {
+                tiles[grid.tile(i, j - 1)].push([w[0], w[1]]);
+                tiles[grid.tile(i, j)].push([w[0], w[1]]);
+            }
+        });
+    }
+
+    tiles
+}
+
+/// Refinement limits of one tile: its share of `max_additional_vertices` and the
+/// request's deadline, plus the request's size field.
+#[derive(Clone)]
+struct TileBudget {
+    vertices: Option<usize>,
+    deadline: Option<Instant>,
+    size_field: Option<Arc<SizeField>>,
+}
+
+fn mesh_tile(input: &Input, segments: &[[[f64; 2]; 2]], budget: &TileBudget) -> Result<Output, String> {
+    let mut vertices = Vec::with_capacity(2 * segments.len());
+    let mut edges = Vec::with_capacity(segments.len());
+    for [a, b] in segments {
+        edges.push([vertices.len(), vertices.len() + 1]);
+        vertices.push(Point2::new(a[0], a[1]));
+        vertices.push(Point2::new(b[0], b[1]));
+    }
+
+    let run = || -> Result<Output, String> {
+        let tile_area = input.tile_size.map_or(0.0, |size| size * size);
+        let expected_vertices = estimate_vertices(vertices.len(), tile_area, input.maxh);
+        let mut mesher = Mesher::from_pslg(input, vertices, edges, expected_vertices).map_err(|e| e.to_string())?;
+        mesher.keep_constraint_edges = true;
+        mesher.vertex_budget = budget.vertices;
+        mesher.deadline = budget.deadline;
+        mesher.size_field = budget.size_field.clone();
+        mesher.threads = 1;
+        let excluded = mesher.refine(input, input.maxh);
+        Ok(mesher.extract(&excluded))
+    };
+    std::panic::catch_unwind(run).unwrap_or_else(|_| Err("tile triangulation panicked".to_string()))
+}
+
+/// Appends tile meshes to one output, numbering each distinct position once.
+struct Merger {
+    output: Output,
+    index: HashMap<(u64, u64), usize>,
+}
+
+impl Merger {
+    fn vertex(&mut self, p: [f64; 3]) -> usize {
+        // `+ 0.0` folds -0.0 into 0.0
+        let key = ((p[0] + 0.0).to_bits(), (p[1] + 0.0).to_bits());
+        let points = &mut self.output.points;
+        *self.index.entry(key).or_insert_with(|| {
+            points.push(p);
+            points.len() - 1
+        })
+    }
+
+    fn append(&mut self, tile: Output, grid: &Grid) {
+        if let Some(timings) = &tile.timings {
+            self.output.timings.get_or_insert_with(Default::default).add(timings);
+        }
+        if let Some(memory) = &tile.memory {
+            self.output.memory.get_or_insert_with(Default::default).add(memory);
+        }
+        if let Some(refinement) = &tile.refinement {
+            match &mut self.output.refinement {
+                Some(merged) => merged.add(refinement),
+                merged => *merged = Some(*refinement),
+            }
+        }
+        let remap: Vec<usize> = tile.points.iter().map(|&p| self.vertex(p)).collect();
+        self.output.triangles.extend(tile.triangles.iter().map(|t| t.map(|v| remap[v])));
+        for &[a, b] in &tile.constraint_edges {
+            if !grid.is_seam(tile.points[a], tile.points[b]) {
+                self.output.constraint_edges.push([remap[a], remap[b]]);
+            }
+        }
+    }
+}
+
+/// Mesh `input` as a grid of `tile_size` tiles and merge the results.
+pub fn triangulate_tiled(input: &Input, tile_size: f64) -> Result<Output, Box<dyn std::error::Error>> {
+    let deadline = input.deadline_ms.map(|ms| Instant::now() + Duration::from_millis(ms));
+    if !(tile_size > 0.0) {
+        return Err("tile_size must be positive".into());
+    }
+    if !input.enforce_constraints || !input.exclude_holes.unwrap_or(true) {
+        return Err("tiling requires enforce_constraints with exclude_holes".into());
+    }
+
+    let loops: Vec<&[[f64; 2]]> = std::iter::once(input.outer.as_slice())
+        .chain(input.inner_loops.iter().map(Vec::as_slice))
+        .filter(|lp| !lp.is_empty())
+        .collect();
+    let all = || loops.iter().flat_map(|lp| lp.iter());
+    if all().next().is_none() {
+        return Ok(Output::default());
+    }
+
+    let (mut min, mut max) = ([f64::INFINITY; 2], [f64::NEG_INFINITY; 2]);
+    for p in all() {
+        for d in 0..2 {
+            min[d] = min[d].min(p[d]);
+            max[d] = max[d].max(p[d]);
+        }
+    }
+    let x0 = choose_origin(all().map(|p| p[0]), min[0], tile_size);
+    let y0 = choose_origin(all().map(|p| p[1]), min[1], tile_size);
+    let grid = Grid {
+        x0,
+        y0,
+        size: tile_size,
+        nx: ((max[0] - x0) / tile_size).floor() as usize + 1,
+        ny: ((max[1] - y0) / tile_size).floor() as usize + 1,
+    };
+
+    let tiles = &decompose(&loops, &grid, input.maxh);
+    let threads = input.threads.unwrap_or_else(pool::default_threads);
+    let meshed_tiles = tiles.iter().filter(|segments| !segments.is_empty()).count().max(1);
+    let budget = &TileBudget {
+        vertices: input.max_additional_vertices.map(|n| n.div_ceil(meshed_tiles)),
+        deadline,
+        size_field: SizeField::from_input(input)?.map(Arc::new),
+    };
+
+    // Merge tiles in index order as they complete, so numbering is deterministic
+    // while finished tile meshes are released early
+    let mut merger = Merger { output: Output::default(), index: HashMap::new() };
+    let mut pending: Vec<Option<Output>> = (0..tiles.len()).map(|_| None).collect();
+    let mut next = 0;
+    let mut error = None;
+
+    pool::for_each_parallel(
+        tiles.len(),
+        threads,
+        |t| if tiles[t].is_empty() { Ok(Output::default()) } else { mesh_tile(input, &tiles[t], budget) },
+        |t, result| match result {
+            Ok(mesh) => {
+                pending[t] = Some(mesh);
+                while next < pending.len() {
+                    let Some(mesh) = pending[next].take() else { break };
+                    merger.append(mesh, &grid);
+                    next += 1;
+                }
+            }
+            Err(e) => {
+                error.get_or_insert(format!("tile {}: {}", t, e));
+            }
+        },
+    );
+
+    if let Some(error) = error {
+        return Err(error.into());
+    }
+    Ok(merger.output)
+}
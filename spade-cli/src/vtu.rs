@@ -0,0 +1,240 @@
+//! Native VTK XML UnstructuredGrid (`.vtu`) writer.
+//!
+//! Writes the same cells as the harness' meshio-based `write_vtu` (triangles,
+//! then constraint edges as lines) using raw appended binary data with UInt64
+//! block headers, optionally compressed with `vtkZLibDataCompressor`.
+
+use crate::{layout, Input, Output};
+use flate2::write::ZlibEncoder;
+use flate2::Compression;
+use std::fs::File;
+use std::io::{self, BufWriter, Write};
+use std::path::Path;
+
+const VTK_LINE: u8 = 3;
+const VTK_TRIANGLE: u8 = 5;
+
+/// Uncompressed bytes per zlib block, as in VTK's own writer
+const BLOCK_BYTES: usize = 1 << 20;
+
+/// The four appended arrays, in file order.
+#[derive(Clone, Copy)]
+enum Array {
+    Points,
+    Connectivity,
+    Offsets,
+    Types,
+}
+
+const ARRAYS: [Array; 4] = [Array::Points, Array::Connectivity, Array::Offsets, Array::Types];
+
+impl Array {
+    fn xml(self, offset: usize) -> String {
+        match self {
+            Array::Points => format!(
+                "<DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"{}\"/>",
+                offset
+            ),
+            Array::Connectivity => format!(
+                "<DataArray type=\"Int64\" Name=\"connectivity\" format=\"appended\" offset=\"{}\"/>",
+                offset
+            ),
+            Array::Offsets => format!(
+                "<DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" offset=\"{}\"/>",
+                offset
+            ),
+            Array::Types => format!(
+                "<DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"{}\"/>",
+                offset
+            ),
+        }
+    }
+
+    fn byte_len(self, mesh: &Output) -> usize {
+        let (t, e) = (mesh.triangles.len(), mesh.constraint_edges.len());
+        match self {
+            Array::Points => 24 * mesh.points.len(),
+            Array::Connectivity => 8 * (3 * t + 2 * e),
+            Array::Offsets => 8 * (t + e),
+            Array::Types => t + e,
+        }
+    }
+
+    fn emit(self, mesh: &Output, w: &mut impl Write) -> io::Result<()> {
+        match self {
+            Array::Points => {
+                for p in &mesh.points {
+                    for c in p {
+                        w.write_all(&c.to_le_bytes())?;
+                    }
+                }
+            }
+            Array::Connectivity => {
+                let cells = mesh.triangles.iter().map(|t| &t[..]).chain(mesh.constraint_edges.iter().map(|e| &e[..]));
+                for cell in cells {
+                    for &v in cell {
+                        w.write_all(&(v as i64).to_le_bytes())?;
+                    }
+                }
+            }
+            Array::Offsets => {
+                let mut end = 0i64;
+                for size in std::iter::repeat(3).take(mesh.triangles.len()).chain(std::iter::repeat(2).take(mesh.constraint_edges.len())) {
+                    end += size;
+                    w.write_all(&end.to_le_bytes())?;
+                }
+            }
+            Array::Types => {
+                w.write_all(&vec![VTK_TRIANGLE; mesh.triangles.len()])?;
+                w.write_all(&vec![VTK_LINE; mesh.constraint_edges.len()])?;
+            }
+        }
+        Ok(())
+    }
+}
+
+/// Collects an array into zlib-compressed blocks plus the VTK block header.
+struct BlockCompressor {
+    block: Vec<u8>,
+    sizes: Vec<u64>,
+    last_block: u64,
+    data: Vec<u8>,
+}
+
+impl BlockCompressor {
+    fn new() -> Self {
+        BlockCompressor { block: Vec::with_capacity(BLOCK_BYTES), sizes: Vec::new(), last_block: 0, data: Vec::new() }
+    }
+
+    fn flush_block(&mut self) -> io::Result<()> {
+        let start = self.data.len();
+        let mut encoder = ZlibEncoder::new(&mut self.data, Compression::default());
+        encoder.write_all(&self.block)?;
+        encoder.finish()?;
+        self.sizes.push((self.data.len() - start) as u64);
+        self.last_block = self.block.len() as u64;
+        self.block.clear();
+        Ok(())
+    }
+
+    /// Header (`[num_blocks, block_size, last_block_size, compressed sizes...]`) and data.
+    fn finish(mut self) -> io::Result<(Vec<u8>, Vec<u8>)> {
+        if !self.block.is_empty() {
+            self.flush_block()?;
+        }
+        let last = if self.last_block as usize == BLOCK_BYTES { 0 } else { self.last_block };
+        let mut header = Vec::with_capacity(8 * (3 + self.sizes.len()));
+        for v in [self.sizes.len() as u64, BLOCK_BYTES as u64, last].into_iter().chain(self.sizes.iter().copied()) {
+            header.extend_from_slice(&v.to_le_bytes());
+        }
+        Ok((header, self.data))
+    }
+}
+
+impl Write for BlockCompressor {
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        let n = buf.len().min(BLOCK_BYTES - self.block.len());
+        self.block.extend_from_slice(&buf[..n]);
+        if self.block.len() == BLOCK_BYTES {
+            self.flush_block()?;
+        }
+        Ok(n)
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        Ok(())
+    }
+}
+
+/// Write `mesh` to `path`. Uncompressed arrays are streamed straight to the file;
+/// compressed ones are compressed first because their sizes go into the XML header.
+pub fn write_vtu(path: impl AsRef<Path>, mesh: &Output, compress: bool) -> io::Result<()> {
+    let compressed = if compress {
+        let mut arrays = Vec::with_capacity(ARRAYS.len());
+        for array in ARRAYS {
+            let mut compressor = BlockCompressor::new();
+            array.emit(mesh, &mut compressor)?;
+            arrays.push(compressor.finish()?);
+        }
+        Some(arrays)
+    } else {
+        None
+    };
+
+    let sizes: Vec<usize> = match &compressed {
+        Some(arrays) => arrays.iter().map(|(header, data)| header.len() + data.len()).collect(),
+        None => ARRAYS.iter().map(|a| 8 + a.byte_len(mesh)).collect(),
+    };
+    let offsets: Vec<usize> = sizes.iter().scan(0, |acc, &n| Some(std::mem::replace(acc, *acc + n))).collect();
+
+    let mut w = BufWriter::with_capacity(1 << 16, File::create(path)?);
+    let compressor = if compress { " compressor=\"vtkZLibDataCompressor\"" } else { "" };
+    writeln!(w, "<?xml version=\"1.0\"?>")?;
+    writeln!(
+        w,
+        "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\"{}>",
+        compressor
+    )?;
+    writeln!(w, "  <UnstructuredGrid>")?;
+    writeln!(
+        w,
+        "    <Piece NumberOfPoints=\"{}\" NumberOfCells=\"{}\">",
+        mesh.points.len(),
+        mesh.triangles.len() + mesh.constraint_edges.len()
+    )?;
+    writeln!(w, "      <Points>\n        {}\n      </Points>", Array::Points.xml(offsets[0]))?;
+    writeln!(w, "      <Cells>")?;
+    for (array, &offset) in ARRAYS.iter().zip(&offsets).skip(1) {
+        writeln!(w, "        {}", array.xml(offset))?;
+    }
+    writeln!(w, "      </Cells>")?;
+    writeln!(w, "    </Piece>")?;
+    writeln!(w, "  </UnstructuredGrid>")?;
+    write!(w, "  <AppendedData encoding=\"raw\">\n   _")?;
+
+    match compressed {
+        Some(arrays) => {
+            for (header, data) in arrays {
+                w.write_all(&header)?;
+                w.write_all(&data)?;
+            }
+        }
+        None => {
+            for array in ARRAYS {
+                w.write_all(&(array.byte_len(mesh) as u64).to_le_bytes())?;
+                array.emit(mesh, &mut w)?;
+            }
+        }
+    }
+
+    writeln!(w, "\n  </AppendedData>")?;
+    writeln!(w, "</VTKFile>")?;
+    w.flush()
+}
+
+/// Apply the `vtu`, `vtu_compress` and `return_mesh` request fields to a finished
+/// mesh, then the reply layout options (see `layout.rs`).
+pub fn write_requested(input: &Input, mut output: Output) -> Result<Output, String> {
+    if let Some(path) = &input.vtu {
+        write_vtu(path, &output, input.vtu_compress.unwrap_or(false)).map_err(|e| format!("{}: {}", path, e))?;
+        if !input.return_mesh.unwrap_or(true) {
+            // The permutations describe the mesh in the file, so they stay
+            let Output {
+                quality, timings, memory, cleanup, refinement, vertex_permutation, triangle_permutation, frame, ..
+            } = output;
+            output = Output {
+                quality,
+                timings,
+                memory,
+                cleanup,
+                refinement,
+                vertex_permutation,
+                triangle_permutation,
+                frame,
+                ..Default::default()
+            };
+        }
+    }
+    layout::apply(input, &mut output);
+    Ok(output)
+}
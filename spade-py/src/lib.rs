@@ -0,0 +1,210 @@
+//! In-process Python bindings for the spade-cli triangulation pipeline.
+//!
+//! Build with `maturin develop --release` from this directory. The module
+//! exposes the same `triangulate()` signature as `adapter_spade.py`, takes
+//! `(N, 2)` float arrays and returns NumPy arrays whose buffers are the Rust
+//! output vectors themselves. The GIL is released while the mesh is built, so
+//! several tiles can be meshed concurrently from a Python thread pool.
+
+use numpy::{Element, PyArray1, PyArray2, PyArrayMethods, PyReadonlyArray2};
+use pyo3::exceptions::{PyRuntimeError, PyValueError};
+use pyo3::prelude::*;
+use pyo3::types::PyDict;
+use spade_cli::frame::Normalize;
+use spade_cli::layout::{CoordType, Dims, IndexType, Layout};
+use spade_cli::renumber::Renumber;
+use spade_cli::Input;
+
+/// Reinterpret a `Vec<[T; N]>` as a flat `Vec<T>` without copying.
+fn flatten<T, const N: usize>(rows: Vec<[T; N]>) -> Vec<T> {
+    let mut rows = std::mem::ManuallyDrop::new(rows);
+    let (ptr, len, cap) = (rows.as_mut_ptr(), rows.len(), rows.capacity());
+    // SAFETY: `[T; N]` has the alignment of `T` and exactly N times its size,
+    // so the allocation is a valid `Vec<T>` of N times the length and capacity.
+    unsafe { Vec::from_raw_parts(ptr as *mut T, len * N, cap * N) }
+}
+
+/// Move an output vector into a NumPy `(len, N)` array that owns the Rust buffer.
+fn into_array<'py, T: Element, const N: usize>(
+    py: Python<'py>,
+    rows: Vec<[T; N]>,
+) -> PyResult<Bound<'py, PyArray2<T>>> {
+    let len = rows.len();
+    PyArray1::from_vec(py, flatten(rows)).reshape([len, N])
+}
+
+fn read_loop(array: &PyReadonlyArray2<'_, f64>) -> PyResult<Vec<[f64; 2]>> {
+    let view = array.as_array();
+    if view.ncols() != 2 {
+        return Err(PyValueError::new_err(format!(
+            "expected an (N, 2) coordinate array, got shape {:?}",
+            view.shape()
+        )));
+    }
+    Ok(view.rows().into_iter().map(|row| [row[0], row[1]]).collect())
+}
+
+type Mesh<'py> = (Bound<'py, PyAny>, Bound<'py, PyAny>, Bound<'py, PyAny>);
+
+/// Points in the requested layout; only the default `f64` 3D layout avoids a copy.
+fn points_array<'py>(py: Python<'py>, points: Vec<[f64; 3]>, layout: Layout) -> PyResult<Bound<'py, PyAny>> {
+    Ok(match (layout.coord, layout.dims.get()) {
+        (CoordType::F64, 3) => into_array(py, points)?.into_any(),
+        (CoordType::F64, _) => into_array(py, points.into_iter().map(|p| [p[0], p[1]]).collect())?.into_any(),
+        (CoordType::F32, 3) => into_array(py, points.into_iter().map(|p| p.map(|c| c as f32)).collect())?.into_any(),
+        (CoordType::F32, _) => into_array(py, points.into_iter().map(|p| [p[0] as f32, p[1] as f32]).collect())?.into_any(),
+    })
+}
+
+/// Index rows as `usize` (no copy) unless `u32` was asked for.
+fn index_array<'py, const N: usize>(
+    py: Python<'py>,
+    rows: Vec<[usize; N]>,
+    index_type: Option<IndexType>,
+) -> PyResult<Bound<'py, PyAny>> {
+    Ok(match index_type {
+        Some(IndexType::U32) => into_array(py, rows.into_iter().map(|r| r.map(|i| i as u32)).collect())?.into_any(),
+        _ => into_array(py, rows)?.into_any(),
+    })
+}
+
+/// Triangulate a polygon with holes.
+///
+/// Returns `(points, triangles, lines)` as `(N, 3)`, `(M, 3)` and `(K, 2)` arrays,
+/// plus an `info` dict with the quality statistics if `return_info` is set.
+#[pyfunction]
+#[pyo3(signature = (
+    outer,
+    inner_loops,
+    *,
+    maxh = None,
+    quality = "default",
+    enforce_constraints = false,
+    min_angle = None,
+    exclude_holes = true,
+    vtu = None,
+    vtu_compress = false,
+    return_mesh = true,
+    return_info = false,
+    clean_tolerance = None,
+    simplify_tolerance = None,
+    normalize = None,
+    max_additional_vertices = None,
+    deadline_ms = None,
+    maxh_min = None,
+    maxh_growth = None,
+    coord_type = "f64",
+    dims = 3,
+    index_type = None,
+    return_edges = true,
+    triangles_only = false,
+    renumber = None,
+    return_permutation = false,
+))]
+#[allow(clippy::too_many_arguments)]
+fn triangulate<'py>(
+    py: Python<'py>,
+    outer: PyReadonlyArray2<'py, f64>,
+    inner_loops: Vec<PyReadonlyArray2<'py, f64>>,
+    maxh: Option<f64>,
+    quality: &str,
+    enforce_constraints: bool,
+    min_angle: Option<f64>,
+    exclude_holes: bool,
+    vtu: Option<String>,
+    vtu_compress: bool,
+    return_mesh: bool,
+    return_info: bool,
+    clean_tolerance: Option<f64>,
+    simplify_tolerance: Option<f64>,
+    normalize: Option<&str>,
+    max_additional_vertices: Option<usize>,
+    deadline_ms: Option<u64>,
+    maxh_min: Option<f64>,
+    maxh_growth: Option<f64>,
+    coord_type: &str,
+    dims: usize,
+    index_type: Option<&str>,
+    return_edges: bool,
+    triangles_only: bool,
+    renumber: Option<&str>,
+    return_permutation: bool,
+) -> PyResult<Bound<'py, PyAny>> {
+    let coord_type = match coord_type {
+        "f32" => CoordType::F32,
+        "f64" => CoordType::F64,
+        other => return Err(PyValueError::new_err(format!("coord_type must be f32 or f64, got {:?}", other))),
+    };
+    let index_type = match index_type {
+        None => None,
+        Some("u32") => Some(IndexType::U32),
+        Some("u64") => Some(IndexType::U64),
+        Some(other) => return Err(PyValueError::new_err(format!("index_type must be u32 or u64, got {:?}", other))),
+    };
+    let normalize = match normalize {
+        None | Some("none") => Normalize::None,
+        Some("center") => Normalize::Center,
+        Some("unit") => Normalize::Unit,
+        Some(other) => return Err(PyValueError::new_err(format!("normalize must be center or unit, got {:?}", other))),
+    };
+    let renumber = match renumber {
+        None | Some("none") => Renumber::None,
+        Some("hilbert") => Renumber::Hilbert,
+        Some("rcm") => Renumber::Rcm,
+        Some(other) => return Err(PyValueError::new_err(format!("renumber must be hilbert or rcm, got {:?}", other))),
+    };
+    let input = Input {
+        outer: read_loop(&outer)?,
+        inner_loops: inner_loops.iter().map(read_loop).collect::<PyResult<_>>()?,
+        maxh,
+        quality: quality.to_string(),
+        enforce_constraints,
+        min_angle,
+        exclude_holes: Some(exclude_holes),
+        vtu,
+        vtu_compress: Some(vtu_compress),
+        return_mesh: Some(return_mesh),
+        quality_metrics: Some(return_info),
+        clean_tolerance,
+        simplify_tolerance,
+        normalize: Some(normalize),
+        max_additional_vertices,
+        deadline_ms,
+        maxh_min,
+        maxh_growth,
+        coord_type: Some(coord_type),
+        dims: Some(Dims::try_from(dims).map_err(PyValueError::new_err)?),
+        index_type,
+        return_edges: Some(return_edges),
+        triangles_only: Some(triangles_only),
+        renumber: Some(renumber),
+        return_permutation: Some(return_permutation),
+        ..Default::default()
+    };
+
+    // A spade panic comes back as an error, not as pyo3's PanicException
+    let output = py.allow_threads(|| spade_cli::try_triangulate(&input)).map_err(PyRuntimeError::new_err)?;
+
+    let info = output.info_json();
+    let mesh: Mesh<'py> = (
+        points_array(py, output.points, output.layout)?,
+        index_array(py, output.triangles, index_type)?,
+        index_array(py, output.constraint_edges, index_type)?,
+    );
+    if !return_info {
+        return Ok(mesh.into_pyobject(py)?.into_any());
+    }
+
+    let info = match info {
+        Some(json) => py.import("json")?.call_method1("loads", (json,))?,
+        None => PyDict::new(py).into_any(),
+    };
+    let (points, triangles, lines) = mesh;
+    Ok((points, triangles, lines, info).into_pyobject(py)?.into_any())
+}
+
+#[pymodule]
+fn spade_py(m: &Bound<'_, PyModule>) -> PyResult<()> {
+    m.add_function(wrap_pyfunction!(triangulate, m)?)?;
+    Ok(())
+}